@@ -0,0 +1,146 @@
+/*
+This commandline application measures how often core-atomic's single attempt operations fail under contention, and what a retry loop around them costs per successful operation.
+
+On a target a failure means an exception came between ldrex and strex, on the host it means another thread changed the datum between the read and the compare-and-swap.
+The loops measured here are the ones that users write: Fifo's retry of atomic_increment, a compare-and-swap such as MpscFifo's claim, and a bounded increment,
+next to atomic_fetchAdd which never retries.
+'window' widens the gap between reading the datum and trying to swap it, standing in for the work done between ldrex and strex, or a long isr entry.
+
+To build:
+g++ -std=c++17 -O2 -pthread atomicretry.cpp core-atomic.cpp stopwatch.cpp
+mv a.out atomicretry
+
+atomicretry [max threads] [operations per thread] [window]
+*/
+
+#include <cstdio>
+#include "stdlib.h"
+#include <thread>
+#include <vector>
+#include <chrono>
+
+#include "core-atomic.h"
+#include "benchmark.h"
+
+static unsigned window = 0;
+
+/** the delay between sampling the datum and the attempt to swap it */
+static void dawdle() {
+  for (unsigned spin = window; spin-- > 0;) {
+    benchKeep(spin);
+  }
+}
+
+/** one increment retried the way Fifo::insert does, @returns how many attempts failed before it worked */
+static unsigned retriedIncrement(unsigned &datum) {
+  unsigned failures = 0;
+  dawdle();
+  while (atomic_increment(datum)) {
+    ++failures;
+  }
+  return failures;
+}
+
+/** one increment done the way MpscFifo claims space, @returns how many attempts failed before it worked */
+static unsigned casIncrement(unsigned &datum) {
+  unsigned failures = 0;
+  while (true) {
+    unsigned was = __atomic_load_n(&datum, __ATOMIC_RELAXED);
+    dawdle();
+    if (!atomic_compareAndSwap(datum, was, was + 1)) {
+      return failures;
+    }
+    ++failures;
+  }
+}
+
+/** a bounded counter, as a semaphore would be kept */
+static unsigned boundedIncrement(unsigned &datum) {
+  unsigned failures = 0;
+  dawdle();
+  while (atomic_incrementNotMax(datum)) {
+    ++failures;
+  }
+  return failures;
+}
+
+static unsigned fetchAdd(unsigned &datum) {
+  dawdle();
+  atomic_fetchAdd(datum, 1);
+  return 0;
+}
+
+struct Outcome {
+  double nanosPerOp;
+  double retriesPerOp;
+  bool counted;
+};
+
+/** @param threads each do @param ops of @param op on one shared datum */
+static Outcome contend(unsigned threads, unsigned ops, unsigned (*op)(unsigned &)) {
+  unsigned datum = 0;
+  std::vector<unsigned> retries(threads, 0);
+  std::vector<std::thread> running;
+  auto started = std::chrono::steady_clock::now();
+  for (unsigned id = 0; id < threads; ++id) {
+    running.emplace_back([&, id] {
+      unsigned failed = 0;
+      for (unsigned count = ops; count-- > 0;) {
+        failed += (*op)(datum);
+      }
+      retries[id] = failed;
+    });
+  }
+  for (auto &thread: running) {
+    thread.join();
+  }
+  std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - started;
+  unsigned total = 0;
+  for (unsigned failed: retries) {
+    total += failed;
+  }
+  double all = double(threads) * ops;
+  return {took.count() / all, total / all, datum == threads * ops};
+}
+
+int main(int argc, char *argv[]) {
+  unsigned maxThreads = argc > 1 ? strtoul(argv[1], nullptr, 0) : 8;
+  unsigned ops = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1000000;
+  window = argc > 3 ? strtoul(argv[3], nullptr, 0) : 0;
+
+  unsigned datum = 0;
+  Benchmark<2000> bench(100, 16);
+  benchmarkReport("uncontended increment", bench.run([&] {
+    benchKeep(retriedIncrement(datum));
+  }));
+  benchmarkReport("uncontended cas increment", bench.run([&] {
+    benchKeep(casIncrement(datum));
+  }));
+  benchmarkReport("uncontended incrementNotMax", bench.run([&] {
+    benchKeep(boundedIncrement(datum));
+  }));
+  benchmarkReport("uncontended fetchAdd", bench.run([&] {
+    benchKeep(fetchAdd(datum));
+  }));
+
+  const struct {
+    const char *name;
+    unsigned (*op)(unsigned &);
+  } loops[] = {
+    {"increment", retriedIncrement},
+    {"cas increment", casIncrement},
+    {"incrementNotMax", boundedIncrement},
+    {"fetchAdd", fetchAdd},
+  };
+
+  unsigned wrong = 0;
+  printf("threads  %-16s  ns/op  retries/op   (window %u, %u ops per thread, %u cores)\n", "loop", window, ops, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    for (const auto &loop: loops) {
+      Outcome outcome = contend(threads, ops, loop.op);
+      printf("%7u  %-16s %6.1f  %10.4f%s\n", threads, loop.name, outcome.nanosPerOp, outcome.retriesPerOp, outcome.counted ? "" : "  LOST COUNTS");
+      wrong += !outcome.counted;
+    }
+  }
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "stopwatch.h"
+#include <algorithm>  //nth_element
+
+/**
+repeatable micro benchmarks built on StopWatchCore::peek(), mostly for the host build where StopWatch reads the thread's cpu time in nanoseconds.
+On a target the units are whatever StopWatch uses there, set STOPWATCH_CYCLES for anything useful.
+
+Each sample times 'batch' calls of the body, so that bodies much shorter than the clock's resolution can still be measured.
+The cost of reading the clock is measured first and taken out of every sample.
+
+Usage:
+  Benchmark<1000> bench(100, 16);//100 warmup calls, 16 calls per sample
+  auto stats = bench.run([&]{ benchKeep(fifo.insert(42)); fifo.clear(); });
+  benchmarkReport("FifoT insert", stats);
+*/
+
+/** keeps the optimizer from discarding a computation whose result the benchmark doesn't otherwise use */
+template<typename T> inline void benchKeep(const T &value) {
+  __asm volatile("" : : "r"(&value) : "memory");
+}
+
+/** per call times in StopWatch units, truncated. */
+struct BenchmarkStats {
+  unsigned samples;
+  unsigned batch;
+  TimeValue min;
+  TimeValue median;
+  TimeValue p99;
+  TimeValue max;
+  /** what was taken out of each sample, per sample not per call */
+  TimeValue overhead;
+};
+
+template<unsigned Samples = 1000> class Benchmark {
+  static_assert(Samples > 0, "need at least one sample");
+  TimeValue sample[Samples];
+
+  /** @returns the sample at fraction @param numerator/@param denominator of the way through the sorted samples */
+  TimeValue percentile(unsigned numerator, unsigned denominator) {
+    unsigned index = (Samples - 1) * numerator / denominator;
+    std::nth_element(sample, sample + index, sample + Samples);
+    return sample[index];
+  }
+
+public:
+  /** calls of the body before timing starts, to get caches and branch predictors into their steady state */
+  unsigned warmup;
+  /** calls of the body per sample */
+  unsigned batch;
+
+  Benchmark(unsigned warmup = 100, unsigned batch = 1) : warmup(warmup), batch(batch ? batch : 1) {}
+
+  template<typename Body> BenchmarkStats run(Body &&body) {
+    StopWatchCore watch;
+    //what peek() itself costs, the least seen is the best estimate as anything else is interference.
+    TimeValue overhead = ~TimeValue(0);
+    watch.peek(true);
+    for (unsigned i = 0; i < Samples; ++i) {
+      TimeValue took = watch.peek(true);
+      if (took < overhead) {
+        overhead = took;
+      }
+    }
+
+    for (unsigned i = warmup; i-- > 0;) {
+      body();
+    }
+
+    watch.peek(true);
+    for (unsigned i = 0; i < Samples; ++i) {
+      for (unsigned b = batch; b-- > 0;) {
+        body();
+      }
+      TimeValue took = watch.peek(true);
+      sample[i] = (took > overhead ? took - overhead : 0) / batch;
+    }
+
+    BenchmarkStats stats;
+    stats.samples = Samples;
+    stats.batch = batch;
+    stats.overhead = overhead;
+    stats.max = *std::max_element(sample, sample + Samples);
+    stats.p99 = percentile(99, 100);
+    stats.median = percentile(1, 2);
+    stats.min = *std::min_element(sample, sample + Samples);
+    return stats;
+  }
+};
+
+#if __linux__
+#include <cstdio>
+
+/** one line summary, nanoseconds per call */
+inline void benchmarkReport(const char *name, const BenchmarkStats &stats, FILE *out = stdout) {
+  fprintf(out, "%-32s min %8llu  median %8llu  p99 %8llu  max %8llu ns  (%u samples of %u, %llu ns clock overhead)\n", name,
+    (unsigned long long) stats.min, (unsigned long long) stats.median, (unsigned long long) stats.p99, (unsigned long long) stats.max,
+    stats.samples, stats.batch, (unsigned long long) stats.overhead);
+}
+#endif
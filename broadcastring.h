@@ -0,0 +1,109 @@
+#pragma once
+
+#include "fifot.h" //FifoIndex, seqWrite, seqRead
+#include <type_traits>
+
+/** one writer, any number of readers each going at its own pace, for fanning out telemetry without a fifo per consumer.
+ * The writer never waits for anyone: a reader that falls more than N-1 items behind loses the oldest ones, and is told how many.
+ * Readers don't alter the ring at all, each Reader object has its own cursor, so adding a consumer costs 8 bytes and no copying by the writer.
+ *
+ * A reader copies an item then checks that the writer hasn't lapped it meanwhile, so T should be small and must be trivially copyable,
+ * a torn copy is detected and discarded rather than prevented. That is the seqlock pattern, see seqWrite() and seqRead() in fifot.h.
+ *
+ * Usage:
+ * BroadcastRing<Sample,32> telemetry;
+ * isr:  telemetry.write(sample);
+ * each consumer: static BroadcastRing<Sample,32>::Reader console(telemetry); Sample s; while(console.read(s)){ show(s); }
+ */
+template<typename T, unsigned N> class BroadcastRing {
+  static_assert(std::is_trivially_copyable<T>::value, "BroadcastRing readers copy items while they might be being overwritten");
+  static_assert(N > 1 && (N & (N - 1)) == 0, "BroadcastRing size must be a power of 2");
+  static constexpr unsigned mask = N - 1;
+
+  /** count of items ever written, only the writer alters it */
+  FifoIndex head;
+  /** the memory*/
+  T mem[N];
+
+  BroadcastRing(const BroadcastRing &) = delete;
+public:
+  BroadcastRing() = default;
+
+  /** writer side: always succeeds, possibly overwriting something a slow reader hasn't gotten to. */
+  void write(const T &incoming) {
+    unsigned writer = head.mine();
+    seqWrite(mem[writer & mask], incoming);
+    head.publish(writer + 1);
+  }
+
+  /** @returns whether item was pushed into the ring, which it always is */
+  bool operator=(const T &incoming) {
+    write(incoming);
+    return true;
+  }
+
+  /** @returns count of items ever written */
+  unsigned written() const {
+    return head.theirs();
+  }
+
+  /** one consumer's view of the ring. */
+  class Reader {
+    const BroadcastRing &ring;
+    /** index of the next item this reader wants */
+    unsigned cursor;
+    /** items that were overwritten before this reader got to them */
+    unsigned lost;
+
+    /** if we have fallen too far behind skip to the oldest item that is not at risk of being overwritten by the write in progress */
+    void catchUp(unsigned writer) {
+      if (writer - cursor > N - 1) {
+        unsigned skip = writer - cursor - (N - 1);
+        lost += skip;
+        cursor += skip;
+      }
+    }
+
+  public:
+    /** starts with only what is written after construction */
+    explicit Reader(const BroadcastRing &ring) : ring(ring), cursor(ring.head.theirs()), lost(0) {}
+
+    /** @returns whether there was an item, which is copied into @param outgoing */
+    bool read(T &outgoing) {
+      while (true) {
+        unsigned writer = ring.head.theirs();
+        if (writer == cursor) {
+          return false;
+        }
+        catchUp(writer);
+        seqRead(outgoing, ring.mem[cursor & mask]);
+        unsigned after = ring.head.recheck();
+        if (after - cursor < N) {
+          ++cursor;
+          return true;
+        }
+        //the writer got to our item while we were copying it, count it lost and try the next oldest.
+        catchUp(after);
+      }
+    }
+
+    /** @returns how many items are waiting for this reader, if more than N-1 some will be lost on the next read() */
+    unsigned lag() const {
+      return ring.head.theirs() - cursor;
+    }
+
+    /** @returns how many items this reader has missed since construction or the last call with @param andClear true */
+    unsigned overruns(bool andClear = false) {
+      unsigned was = lost;
+      if (andClear) {
+        lost = 0;
+      }
+      return was;
+    }
+
+    /** drop whatever is pending, next read() gets only newer items */
+    void skipToNow() {
+      cursor = ring.head.theirs();
+    }
+  };
+};
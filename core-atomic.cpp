@@ -3,57 +3,248 @@
 * only include this if your processor has ldrex and strex instructions.
  */
 
-#if __has_include(<atomic>)
-#include <atomic>  //todo:1 actually use it rather than our own cortexm3.s file.
-#endif
+/** cortex M atomic operations */
+#if __linux__
+/* host build, for testing users of these with real threads.
+ * These are the same builtins that std::atomic is made of, used directly as std::atomic can't be applied to an existing unsigned (until c++20's atomic_ref).
+ * A collision in a single attempt operation is reported just as the ldrex/strex version would, the caller's retry logic then gets exercised. */
 
+static bool swapIf(unsigned &alignedDatum, unsigned expected, unsigned desired){
+  return !__atomic_compare_exchange_n(&alignedDatum, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
 
-/** cortex M atomic operations */
-#if __linux__   //create stubs, perhaps someday use <atomic> to do a real implementation.
+//a single compare-and-swap rather than a locked add, so that these can fail as their ldrex/strex versions do
 bool atomic_increment(unsigned &alignedDatum){
-  ++alignedDatum;
-  return false;
+  return atomic_add(alignedDatum, 1);
 }
 
 bool atomic_decrement(unsigned &alignedDatum){
-  --alignedDatum;
-  return false;
+  return atomic_add(alignedDatum, ~0u);
+}
+
+bool atomic_add(unsigned &alignedDatum, unsigned amount){
+  unsigned was = __atomic_load_n(&alignedDatum, __ATOMIC_ACQUIRE);
+  return swapIf(alignedDatum, was, was + amount);
 }
 
 bool atomic_decrementNotZero(unsigned &alignedDatum){
-  if(alignedDatum) {
-    --alignedDatum;
-    return true;
+  unsigned was = __atomic_load_n(&alignedDatum, __ATOMIC_ACQUIRE);
+  if(was == 0) {
+    return false;
   }
-  return false;
+  return swapIf(alignedDatum, was, was - 1);
 }
 
 bool atomic_incrementNotMax(unsigned &alignedDatum){
-  if(alignedDatum != 0xffffffff) {
-    ++alignedDatum;
+  unsigned was = __atomic_load_n(&alignedDatum, __ATOMIC_ACQUIRE);
+  if(was == ~0u) {
+    return false;
   }
-  return false;
+  return swapIf(alignedDatum, was, was + 1);
+}
+
+bool atomic_decrementNowZero(unsigned &alignedDatum){
+  unsigned was = __atomic_load_n(&alignedDatum, __ATOMIC_ACQUIRE);
+  do {
+    if(was == 0) {
+      return true;
+    }
+  } while(!__atomic_compare_exchange_n(&alignedDatum, &was, was - 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  return was == 1;
+}
+
+bool atomic_incrementWasZero(unsigned &alignedDatum){
+  unsigned was = __atomic_load_n(&alignedDatum, __ATOMIC_ACQUIRE);
+  do {
+    if(was == ~0u) {
+      return false;
+    }
+  } while(!__atomic_compare_exchange_n(&alignedDatum, &was, was + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  return was == 0;
+}
+
+bool atomic_compareAndSwap(unsigned &alignedDatum, unsigned expected, unsigned desired){
+  return swapIf(alignedDatum, expected, desired);
 }
 
 bool atomic_setIfZero(unsigned &alignedDatum, unsigned value){
-  if(alignedDatum == 0){
-    alignedDatum=value;
-  }
-  return false;
+  return swapIf(alignedDatum, 0, value);
 }
+
+unsigned atomic_fetchAdd(unsigned &alignedDatum, unsigned amount){
+  return __atomic_fetch_add(&alignedDatum, amount, __ATOMIC_ACQ_REL);
+}
+
+unsigned atomic_exchange(unsigned &alignedDatum, unsigned value){
+  return __atomic_exchange_n(&alignedDatum, value, __ATOMIC_ACQ_REL);
+}
+
 #else // real code
 
+//"If a store-exclusive instruction performs the store, it writes 0 to its destination register.
+// If it does not perform the store, it writes 1 to its destination register."
+//An exception entry or return clears the exclusive monitor, so an isr that runs between ldrex and strex makes the strex fail.
+//When we bail out without a strex we clrex so that the next ldrex/strex pair elsewhere isn't confused by our leftover.
+
+//store r1 and return 'failed' in r0
+#define Strexit1 \
+  "\nstrex r2,r1,[r0]" \
+  "\nmov r0,r2" \
+  "\nbx lr"
+
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
 __attribute__((naked))
 bool atomic_increment(unsigned & counter){
   asm volatile(
     "\nldrex r1,[r0]"
     "\nadd r1,r1,#1"
+    Strexit1
+      );
+}
+
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
+__attribute__((naked))
+bool atomic_decrement(unsigned &alignedDatum){
+  asm volatile(
+    "\nldrex r1,[r0]"
+    "\nsub r1,r1,#1"
+    Strexit1
+      );
+}
+
+//r0 address, r1 amount, r2 scratched
+__attribute__((naked))
+bool atomic_add(unsigned &alignedDatum, unsigned amount){
+  asm volatile(
+    "\nldrex r2,[r0]"
+    "\nadd r2,r2,r1"
+    "\nstrex r1,r2,[r0]"
+    "\nmov r0,r1"
+    "\nbx lr"
+      );
+}
+
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
+__attribute__((naked))
+bool atomic_decrementNotZero(unsigned &alignedDatum){
+  asm volatile(
+    "\nldrex r1,[r0]"
+    "\ncbz r1,1f"
+    "\nsub r1,r1,#1"
+    Strexit1
+    "\n1: clrex   //was 0, nothing to do and that is not a failure"
+    "\nmov r0,#0"
+    "\nbx lr"
+      );
+}
+
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
+__attribute__((naked))
+bool atomic_incrementNotMax(unsigned &alignedDatum){
+  asm volatile(
+    "\nldrex r1,[r0]"
+    "\nadd r1,r1,#1"
+    "\ncbz r1,1f  //wrapped, was all ones"
+    Strexit1
+    "\n1: clrex"
+    "\nmov r0,#0"
+    "\nbx lr"
+      );
+}
+
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
+__attribute__((naked))
+bool atomic_decrementNowZero(unsigned &alignedDatum){
+  asm volatile(
+    "\n0: ldrex r1,[r0]"
+    "\ncbz r1,1f"
+    "\nsub r1,r1,#1"
     "\nstrex r2,r1,[r0]"
-    "\nmov r0,r2"
+    "\ncmp r2,#0"
+    "\nbne 0b     //collision, try again"
+    "\ncbz r1,2f  //decremented to zero"
+    "\nmov r0,#0"
+    "\nbx lr"
+    "\n1: clrex   //was already zero"
+    "\n2: mov r0,#1"
     "\nbx lr"
       );
 }
 
-#endif // if HOST_SIM
+//r0 address, trusted to be 32-bit aligned. r1,r2 scratched.
+__attribute__((naked))
+bool atomic_incrementWasZero(unsigned &alignedDatum){
+  asm volatile(
+    "\n0: ldrex r1,[r0]"
+    "\nadd r1,r1,#1"
+    "\ncbz r1,1f  //was all ones, leave it so"
+    "\nstrex r2,r1,[r0]"
+    "\ncmp r2,#0"
+    "\nbne 0b     //collision, try again"
+    "\ncmp r1,#1"
+    "\nbne 2f"
+    "\nmov r0,#1"
+    "\nbx lr"
+    "\n1: clrex"
+    "\n2: mov r0,#0"
+    "\nbx lr"
+      );
+}
 
+//r0 address, r1 expected, r2 desired, r3 scratched
+__attribute__((naked))
+bool atomic_compareAndSwap(unsigned &alignedDatum, unsigned expected, unsigned desired){
+  asm volatile(
+    "\nldrex r3,[r0]"
+    "\ncmp r3,r1"
+    "\nbne 1f"
+    "\nstrex r3,r2,[r0]"
+    "\nmov r0,r3"
+    "\nbx lr"
+    "\n1: clrex  //not what was expected, drop the lock and report failure"
+    "\nmov r0,#1"
+    "\nbx lr"
+      );
+}
+
+//r0 address, trusted to be 32-bit aligned. r1 new value, r2 scratched.
+__attribute__((naked))
+bool atomic_setIfZero(unsigned &alignedDatum, unsigned value){
+  asm volatile(
+    "\nldrex r2,[r0]"
+    "\ncbnz r2,1f"
+    Strexit1
+    "\n1: clrex  //not zero, drop the lock and report failure"
+    "\nmov r0,#1"
+    "\nbx lr"
+      );
+}
+
+//r0 address, r1 amount, r2 old value, r3 new value, r12 scratched
+__attribute__((naked))
+unsigned atomic_fetchAdd(unsigned &alignedDatum, unsigned amount){
+  asm volatile(
+    "\n0: ldrex r2,[r0]"
+    "\nadd r3,r2,r1"
+    "\nstrex r12,r3,[r0]"
+    "\ncmp r12,#0"
+    "\nbne 0b"
+    "\nmov r0,r2"
+    "\nbx lr"
+      );
+}
+
+//r0 address, r1 new value, r2 old value, r3 scratched
+__attribute__((naked))
+unsigned atomic_exchange(unsigned &alignedDatum, unsigned value){
+  asm volatile(
+    "\n0: ldrex r2,[r0]"
+    "\nstrex r3,r1,[r0]"
+    "\ncmp r3,#0"
+    "\nbne 0b"
+    "\nmov r0,r2"
+    "\nbx lr"
+      );
+}
 
+#endif // if __linux__
@@ -6,25 +6,39 @@
  * If you are sure the cause of failure isn't permanent then: do{}while(atomic_increment(arg));
  *
  * we don't use <atomic> as it doesn't allow for walking away from an operation if there is a collision.
+ * The host (__linux__) build does use the compiler's atomic builtins so that users can be tested with real threads.
+ * There every single-attempt function is one compare-and-swap, which fails when another thread changed the datum since it was read, so callers' retry paths get exercised.
 */
 bool atomic_increment(unsigned &alignedDatum);
 
 /** @return whether the alignedDatum FAILED to decrement */
 bool atomic_decrement(unsigned &alignedDatum);
 
-/** @return whether the following logic succeeded, not whether it actually decremented: if datum is not zero decrement it */
+/** @return whether the alignedDatum FAILED to have @param amount added to it. Subtract by adding the 2's complement. */
+bool atomic_add(unsigned &alignedDatum, unsigned amount);
+
+/** @return whether the following logic FAILED, not whether it actually decremented: if datum is not zero decrement it */
 bool atomic_decrementNotZero(unsigned &alignedDatum);
 
-/** @return whether the following logic succeeded, not whether it actually incremented: if datum is not all ones then increment it */
+/** @return whether the following logic FAILED, not whether it actually incremented: if datum is not all ones then increment it */
 bool atomic_incrementNotMax(unsigned &alignedDatum);
 
-/** @returns 1 if the value was zero in which case it is still 0, else blocks until decrement and returns 0 (regardless of decremented value) */
+/** blocks until it has decremented a non-zero datum, @returns whether the datum is now zero, which includes it having been zero in which case it is left 0. */
 bool atomic_decrementNowZero(unsigned &alignedDatum);
 
-/** @returns whether the value was zero before increment, if datum is all ones then left all ones. */
+/** @returns whether the value was zero before increment, if datum is all ones then left all ones. Blocks until the increment succeeds. */
 bool atomic_incrementWasZero(unsigned &alignedDatum);
 
-/** @return whether the following logic succeeded, if datum IS zero then replace it with given value */
+/** @return whether the alignedDatum FAILED to be replaced with @param desired, which happens if it wasn't @param expected or if there was a collision */
+bool atomic_compareAndSwap(unsigned &alignedDatum, unsigned expected, unsigned desired);
+
+/** @return whether the following logic FAILED: if datum IS zero then replace it with given value. Not being zero counts as a failure. */
 bool atomic_setIfZero(unsigned &alignedDatum, unsigned value);
 
+/** blocks until it has added @param amount, @returns the value before the add */
+unsigned atomic_fetchAdd(unsigned &alignedDatum, unsigned amount);
+
+/** blocks until it has stored @param value, @returns the value that was replaced */
+unsigned atomic_exchange(unsigned &alignedDatum, unsigned value);
+
 #endif // COREATOMIC_H
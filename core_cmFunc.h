@@ -89,7 +89,11 @@ extern const struct BasePriority {
     return result;
   }
   void operator=(unsigned stacktop)const {
-    __asm volatile("MSR basepri, %0\n" : : "r" (stacktop));
+    __asm volatile("MSR basepri, %0\n" : : "r" (stacktop) : "memory");
+  }
+  /** only takes effect if it masks more than what is already masked, which makes nesting free */
+  void raise(unsigned level)const {
+    __asm volatile("MSR basepri_max, %0\n" : : "r" (level) : "memory");
   }
 }BASEPRI;
 
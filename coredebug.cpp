@@ -3,7 +3,20 @@
 
 #include "peripheraltypes.h"
 
-struct CoreDebug {
+namespace CoreDebug {
+  constexpr Address DHCSR = 0xE000'EDF0;
+  constexpr Address DEMCR = 0xE000'EDFC;
+
+  void enableTrace(bool on) {
+    SFRbit<DEMCR, 24>() = on;
+  }
+
+  bool debuggerAttached() {
+    return SFRbit<DHCSR, 0>();
+  }
+}
+
+struct CoreDebugRegs {
   SFR DHCSR;                   /*!< Offset: 0x000 (R/W)  Debug Halting Control and Status Register    */
   SFR DCRSR;                  /*!< Offset: 0x004 ( /W)  Debug Core Register Selector Register        */
   SFR DCRDR;                   /*!< Offset: 0x008 (R/W)  Debug Core Register Data Register            */
@@ -1,10 +1,13 @@
 #ifndef COREDEBUG_H
 #define COREDEBUG_H
 
-// class CoreDebug
-// {
-// public:
-//  CoreDebug();
-// };
+/** core debug block, the parts a running program might want without a debugger attached. */
+namespace CoreDebug {
+  /** DEMCR.TRCENA: master enable for the DWT and ITM blocks. Debuggers usually set it, a free running board won't have it set. */
+  void enableTrace(bool on = true);
+
+  /** @returns whether a debugger has the core enabled for halting, DHCSR.C_DEBUGEN */
+  bool debuggerAttached();
+}
 
 #endif // COREDEBUG_H
@@ -2,8 +2,17 @@
 /**
 * replacing cortexm3.s via __attribute__ ((naked))
  */
+#if NANOSPIN_CYCLES  //project wide option, nanoSpin() times itself with the DWT cycle counter instead of trusting instruction timing.
+#include "cycleclock.h"
+
+//pertick is ignored, CycleClock knows the clock rate. CycleClock::start() must have been called, and nanos is taken at face value.
+void nanoSpin(unsigned nanos, unsigned /*pertick*/) {
+  CycleClock::spinNanos(nanos);
+}
+#else
 //r0 is nano seconds, r1 is number of nanoseconds per iteration of this function. That was 83ns for a 72MHz M3.
 //caller must pre-tweak value for function call overhead.
+//CycleClock::spinNanos() is independent of instruction timing, if you can spare the DWT, set NANOSPIN_CYCLES to have this use it.
 __attribute__((naked))
 void nanoSpin(unsigned nanos, unsigned pertick) {
   asm volatile (
@@ -12,6 +21,7 @@ void nanoSpin(unsigned nanos, unsigned pertick) {
     "\nbx lr"
   );
 }
+#endif
 
 
 float shiftScale(float eff, int pow2) {
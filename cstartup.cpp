@@ -31,11 +31,9 @@ void run_table(const InitRoutine *table) {
 }
 
 #if VECTORSINRAM == 1
-const extern RamInitBlock __CCM_Vectors__;//name coordinated with cortexm.ld
-void vectors2ram() {
-  __CCM_Vectors__.go();
-  SFRint<unsigned *,0xE000ED08> ()=__CCM_Vectors__.ram.address;
-}
+#include "ramvectors.h"
+//the table is in .bss, which was cleared just before this is called.
+#define vectors2ram() RamVectors::install()
 #else
 #define vectors2ram()
 #endif
@@ -0,0 +1,129 @@
+#include "cycleclock.h"
+
+#ifdef __linux__ //host build, nanoseconds standing in for cycles so that timing code can be exercised.
+#include <time.h>
+
+namespace CycleClock {
+  void start() {
+    //nothing to do
+  }
+
+  CycleCount now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return CycleCount(ts.tv_sec) * 1000'000'000 + ts.tv_nsec;
+  }
+
+  u32 snap() {
+    return u32(now());
+  }
+
+  Hertz rate() {
+    return 1000'000'000;
+  }
+
+  void keepUp() {
+    //nothing to do
+  }
+}
+
+#else
+
+#include "peripheraltypes.h"
+#include "coredebug.h"
+#include "clocks.h"
+#include "tableofpointers.h"
+#include "systick.h"
+
+constexpr Address DWT_CTRL = 0xE000'1000;
+constexpr Address DWT_CYCCNT = 0xE000'1004;
+//M7's lock the DWT, others ignore this:
+constexpr Address DWT_LAR = 0xE000'1FB0;
+
+const SFR32<DWT_CYCCNT> cyccnt;
+
+/** the extension of the counter, the tick isr writes the slot that readers aren't being told to use then flips 'current'.
+ * A reader that sees 'current' unchanged across its read of a slot got a consistent pair, even if it preempted the tick isr. */
+struct Epoch {
+  u32 high;
+  u32 low;
+};
+
+static Epoch epochs[2];
+static volatile unsigned current = 0;
+
+namespace CycleClock {
+  void start() {
+    CoreDebug::enableTrace(true);
+    SFR32<DWT_LAR>() = 0xC5AC'CE55;
+    SFRbit<DWT_CTRL, 0>() = true;
+  }
+
+  u32 snap() {
+    return cyccnt;
+  }
+
+  void keepUp() {
+    const Epoch &was = epochs[current];
+    Epoch &next = epochs[current ^ 1];
+    u32 low = cyccnt;
+    next.high = was.high + (low < was.low);
+    next.low = low;
+    __asm volatile("" ::: "memory");
+    current ^= 1;
+  }
+
+  CycleCount now() {
+    unsigned which;
+    Epoch snapped;
+    u32 low;
+    do {
+      which = current;
+      __asm volatile("" ::: "memory");
+      snapped = epochs[which];
+      low = cyccnt;
+      __asm volatile("" ::: "memory");
+    } while (which != current);
+    //if the counter has wrapped since the tick noted it then we count that wrap ourselves
+    return (CycleCount(snapped.high + (low < snapped.low)) << 32) | low;
+  }
+
+  Hertz rate() {
+    return clockRate(CPU);
+  }
+}
+
+#if SYSTICK_TICKLESS
+/** a SystemTicker would only be called when something else wakes the tick, we ask to be woken at least twice per counter wrap */
+static SysTicks cycleClockDeadline(SysTicks /*elapsed*/) {
+  CycleClock::keepUp();
+  return SystemTimer::ticksPerSecond() * (~0u / CycleClock::rate()) / 2;
+}
+
+MakeRef(DeadlineTicker, cycleClockDeadline);
+#else
+static void cycleClockTick() {
+  CycleClock::keepUp();
+}
+
+MakeRef(SystemTicker, cycleClockTick);
+#endif
+
+#endif
+
+namespace CycleClock {
+  double secondsFor(CycleCount cycles) {
+    return double(cycles) / double(rate());
+  }
+
+  void spin(u32 cycles) {
+    u32 began = snap();
+    while (snap() - began < cycles) {
+      //burn
+    }
+  }
+
+  void spinNanos(u32 nanos) {
+    spin(u32(cyclesForNanos(rate(), nanos)));
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "eztypes.h"
+
+/**
+cycle accurate time from the DWT cycle counter, M3 and up only (M0's don't have CYCCNT).
+
+The 32 bit counter wraps in under a minute at typical clock rates, it is extended to 64 bits by noting wraps from the system tick,
+so SystemTimer must be running (at any rate faster than one wrap) for now() to be right. snap() is always right for intervals less than a wrap.
+
+Usage:
+  CycleClock::start();//once, after clocks are set up
+  ...
+  u32 began=CycleClock::snap();
+  isrpath();
+  u32 took=CycleClock::snap()-began; //unsigned math handles the wrap
+*/
+
+using CycleCount = u64;
+
+namespace CycleClock {
+  /** turns on trace and the counter. */
+  void start();
+
+  /** @returns the raw 32 bit counter, cheapest possible read (one load) */
+  u32 snap();
+
+  /** @returns 64 bit cycles since start() */
+  CycleCount now();
+
+  /** @returns the rate the counter runs at, the cpu clock */
+  Hertz rate();
+
+  double secondsFor(CycleCount cycles);
+
+  /** busy wait for at least @param cycles. Unlike nanoSpin() this doesn't care about instruction timing, only the counter. Set NANOSPIN_CYCLES project wide to have nanoSpin() use spinNanos(). */
+  void spin(u32 cycles);
+
+  /** busy wait for at least @param nanos nanoseconds */
+  void spinNanos(u32 nanos);
+
+  /** to be called at least once per counter wrap, SystemTimer's tick does that for us. */
+  void keepUp();
+
+  ///////////////////
+  // conversions for when the clock rate is known at compile time, they reduce to constants if given constants.
+
+  constexpr CycleCount cyclesFor(Hertz atHz, u64 amount, u64 perSecond) {
+    return (amount / perSecond) * atHz + ((amount % perSecond) * atHz) / perSecond;
+  }
+
+  constexpr CycleCount cyclesForNanos(Hertz atHz, u64 nanos) {
+    return cyclesFor(atHz, nanos, 1000'000'000);
+  }
+
+  constexpr CycleCount cyclesForMicros(Hertz atHz, u64 micros) {
+    return cyclesFor(atHz, micros, 1000'000);
+  }
+
+  /** truncates, as is appropriate for 'has this much time elapsed' */
+  constexpr u64 unitsFor(Hertz atHz, CycleCount cycles, u64 perSecond) {
+    return (cycles / atHz) * perSecond + ((cycles % atHz) * perSecond) / atHz;
+  }
+
+  constexpr u64 nanosFor(Hertz atHz, CycleCount cycles) {
+    return unitsFor(atHz, cycles, 1000'000'000);
+  }
+
+  constexpr u64 microsFor(Hertz atHz, CycleCount cycles) {
+    return unitsFor(atHz, cycles, 1000'000);
+  }
+}
@@ -0,0 +1,114 @@
+#include "deferred.h"
+#include "mpscfifo.h"
+#include "nvic.h"
+#include "peripheraltypes.h"
+
+#if defined(__CORTEX_M) && __CORTEX_M < 3
+#error "Deferred needs ldrex/strex for its queues (and the DWT for DEFERRED_STATS), which M0's don't have"
+#endif
+
+#if DEFERRED_STATS
+#include "cycleclock.h"
+#endif
+
+namespace Deferred {
+  struct Item {
+    Work work;
+    void *context;
+#if DEFERRED_STATS
+    u32 posted;
+#endif
+  };
+
+  static MpscRecordQueue<DEFERRED_QUEUE_BYTES> queue[DEFERRED_LEVELS];
+  static unsigned lost[DEFERRED_LEVELS];
+#if DEFERRED_STATS
+  static Stats measured[DEFERRED_LEVELS];
+#endif
+
+  /** ICSR PENDSVSET */
+  static void pend() {
+    SFRint<unsigned, SCB(0x04)>() = 1u << 28;
+  }
+
+  void init() {
+    setInterruptPriorityFor(-14, 0xFF >> PriorityShift);
+#if DEFERRED_STATS
+    CycleClock::start();//the latency and runtime figures come from it
+    resetStats();
+#endif
+  }
+
+  bool post(Work work, void *context, unsigned level) {
+    if (level >= DEFERRED_LEVELS) {
+      level = DEFERRED_LEVELS - 1;
+    }
+    auto *item = static_cast<Item *>(queue[level].reserve(sizeof(Item)));
+    if (!item) {
+      atomic_fetchAdd(lost[level], 1);
+      return false;
+    }
+    item->work = work;
+    item->context = context;
+#if DEFERRED_STATS
+    item->posted = CycleClock::snap();
+#endif
+    queue[level].commit(item);
+    pend();
+    return true;
+  }
+
+  /** @returns whether an item was run, from the most urgent level that had one */
+  static bool runOne() {
+    for (unsigned level = 0; level < DEFERRED_LEVELS; ++level) {
+      if (auto record = queue[level].front()) {
+        Item item = *reinterpret_cast<const Item *>(record.data);
+        queue[level].pop(); //before running so that the work can post again, even to a full queue.
+#if DEFERRED_STATS
+        u32 started = CycleClock::snap();
+        (*item.work)(item.context);
+        Stats &stats = measured[level];
+        ++stats.count;
+        stats.latency.note(started - item.posted);
+        stats.runtime.note(CycleClock::snap() - started);
+#else
+        (*item.work)(item.context);
+#endif
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void drain() {
+    while (runOne()) {
+      //a post of something more urgent while an item runs will be run next
+    }
+  }
+
+  unsigned dropped(unsigned level) {
+    return level < DEFERRED_LEVELS ? lost[level] : 0;
+  }
+
+#if DEFERRED_STATS
+  bool stats(unsigned level, Stats &copy) {
+    if (level >= DEFERRED_LEVELS) {
+      return false;
+    }
+    InterruptMask masked; //PendSV could be midway through an update of these
+    copy = measured[level];
+    return true;
+  }
+
+  void resetStats() {
+    InterruptMask masked;
+    for (Stats &stats: measured) {
+      stats = {0, {~0u, 0, 0}, {~0u, 0, 0}};
+    }
+  }
+#endif
+}
+
+HandleFault(14) {
+  Deferred::drain();
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "eztypes.h"
+
+/**
+deferred work, aka bottom halves: an isr does the minimum at its own priority and posts the rest to be run at the lowest priority.
+
+Posting is lock-free from any priority, each level is an MpscRecordQueue. PendSV runs at the lowest priority and drains the queues,
+more urgent levels first, FIFO within a level. Level 0 is the most urgent, as with nvic priorities.
+Work runs with interrupts enabled and is preempted by every isr, so it must not block and it had better finish well before it is posted again.
+
+This module implements the PendSV handler (HandleFault(14)), don't use it with an RTOS that wants PendSV for itself.
+M3 and up only, posting relies on ldrex/strex.
+
+Usage:
+  Deferred::init();//once, before the first post
+  ...
+  HandleInterrupt(37){
+    uart.grabByte();
+    Deferred::post<Uart, &Uart::parse>(uart);
+  }
+
+With DEFERRED_STATS set (M3 and up) each level tracks how long items waited between post and run, and how long they ran for.
+The total run time is the time moved off of the isr's.
+*/
+
+/** number of priority levels, each has its own queue */
+#ifndef DEFERRED_LEVELS
+#define DEFERRED_LEVELS 2
+#endif
+
+/** bytes per level queue, each item takes 12, 16 with DEFERRED_STATS */
+#ifndef DEFERRED_QUEUE_BYTES
+#define DEFERRED_QUEUE_BYTES 256
+#endif
+
+#ifndef DEFERRED_STATS
+#define DEFERRED_STATS 0
+#endif
+
+namespace Deferred {
+  using Work = void (*)(void *context);
+
+  /** sets PendSV to the lowest priority, and with DEFERRED_STATS starts the CycleClock */
+  void init();
+
+  /** any priority: queue @param work to be called with @param context at @param level. @returns whether there was room, failures are counted. */
+  bool post(Work work, void *context = nullptr, unsigned level = 0);
+
+  /** @param object must still exist when the work runs */
+  template<typename T, void (T::*method)()> bool post(T &object, unsigned level = 0) {
+    return post([](void *context) {
+      (static_cast<T *>(context)->*method)();
+    }, &object, level);
+  }
+
+  /** runs everything that is queued, the PendSV handler calls this. Other callers must be less urgent than any poster, or else fifo order within a level is lost. */
+  void drain();
+
+  /** @returns number of posts that didn't fit, for @param level */
+  unsigned dropped(unsigned level);
+
+#if DEFERRED_STATS
+  /** cycle counts of one aspect of deferred items */
+  struct Spread {
+    u32 min;
+    u32 max;
+    u64 sum;
+
+    void note(u32 cycles) {
+      if (cycles < min) {
+        min = cycles;
+      }
+      if (cycles > max) {
+        max = cycles;
+      }
+      sum += cycles;
+    }
+  };
+
+  struct Stats {
+    unsigned count;
+    /** from post to start of run */
+    Spread latency;
+    /** execution time of the work, the time taken off of the isr's that posted it */
+    Spread runtime;
+
+    u32 averageLatency() const {
+      return count ? u32(latency.sum / count) : 0;
+    }
+
+    u32 averageRuntime() const {
+      return count ? u32(runtime.sum / count) : 0;
+    }
+  };
+
+  /** @returns copy of the stats of @param level, false if level is out of range */
+  bool stats(unsigned level, Stats &copy);
+
+  void resetStats();
+#endif
+}
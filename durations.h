@@ -0,0 +1,221 @@
+#pragma once
+
+#include <stdint.h>
+#include <type_traits>
+#include <limits>
+
+/**
+durations and time points with the unit in the type, so that mixing milliseconds with ticks is a compile error rather than a bug,
+and so that conversions between units known at compile time fold to a multiply or divide by a constant, no double.
+
+A Duration<Rep,Num,Den> is a count of Num/Den seconds. Conversion is implicit only when it is exact and can't overflow, that is to a unit that divides this one
+and whose Rep can hold every count of this one's in that unit: Micros to LongMicros or Nanos, Seconds to LongMicros, but not Seconds or Millis to Micros.
+Anything else, including narrowing LongMicros to Micros, needs durationCast<>.
+Comparing or adding durations of different types converts whichever side converts as above, so LongMicros + Micros is a LongMicros,
+and if neither does the compiler complains and you pick with durationCast<>.
+
+A TimePoint is a reading of some clock, the Clock type is only a tag that keeps readings of different clocks apart.
+The counts wrap, comparisons are by signed difference so they are right as long as the two readings are within half the range of each other.
+
+  using namespace Time::literals;
+  Time::LongMicros settle = 250_us;
+  if(elapsed > 2_ms + settle) ...
+*/
+
+namespace Time {
+  constexpr uint64_t gcd(uint64_t a, uint64_t b) {
+    return b ? gcd(b, a % b) : a;
+  }
+
+  /** multiplier and divisor for converting a count of @param FromNum/@param FromDen units to @param ToNum/@param ToDen units, reduced */
+  template<uint64_t FromNum, uint64_t FromDen, uint64_t ToNum, uint64_t ToDen> struct Scale {
+    static constexpr uint64_t upper = FromNum * ToDen;
+    static constexpr uint64_t lower = FromDen * ToNum;
+    static constexpr uint64_t mul = upper / gcd(upper, lower);
+    static constexpr uint64_t div = lower / gcd(upper, lower);
+    static constexpr bool exact = div == 1;
+
+    /** split so that count*mul only overflows if the answer does */
+    template<typename Rep> static constexpr Rep apply(uint64_t count) {
+      return Rep(div == 1 ? count * mul : (count / div) * mul + ((count % div) * mul) / div);
+    }
+  };
+
+  /** whether counts of @param FromRep at @param FromNum/@param FromDen convert to @param ToRep at @param ToNum/@param ToDen exactly and without overflow */
+  template<typename FromRep, uint64_t FromNum, uint64_t FromDen, typename ToRep, uint64_t ToNum, uint64_t ToDen> struct Lossless {
+    using scale = Scale<FromNum, FromDen, ToNum, ToDen>;
+    static constexpr bool value = scale::exact && uint64_t(std::numeric_limits<FromRep>::max()) <= uint64_t(std::numeric_limits<ToRep>::max()) / scale::mul;
+  };
+
+  template<typename Rep, uint64_t Num, uint64_t Den> struct Duration {
+    static_assert(std::is_unsigned<Rep>::value, "durations are unsigned, wrap handling is done by TimePoint");
+    static_assert(Num > 0 && Den > 0, "unit must be a positive ratio, for ticks check that the rate is known");
+    using rep = Rep;
+    static constexpr uint64_t num = Num;
+    static constexpr uint64_t den = Den;
+
+    Rep count;
+
+    constexpr Duration() : count(0) {}
+
+    constexpr explicit Duration(Rep count) : count(count) {}
+
+    /** implicit from any duration that converts losslessly, see the file comment */
+    template<typename R2, uint64_t N2, uint64_t D2, typename = std::enable_if_t<Lossless<R2, N2, D2, Rep, Num, Den>::value>>
+    constexpr Duration(Duration<R2, N2, D2> other) : count(Scale<N2, D2, Num, Den>::template apply<Rep>(other.count)) {}
+
+    friend constexpr Duration operator+(Duration a, Duration b) {
+      return Duration(Rep(a.count + b.count));
+    }
+
+    friend constexpr Duration operator-(Duration a, Duration b) {
+      return Duration(Rep(a.count - b.count));
+    }
+
+    friend constexpr Duration operator*(Duration a, Rep factor) {
+      return Duration(Rep(a.count * factor));
+    }
+
+    friend constexpr Duration operator/(Duration a, Rep divisor) {
+      return Duration(Rep(a.count / divisor));
+    }
+
+    /** how many whole b's fit in a */
+    friend constexpr Rep operator/(Duration a, Duration b) {
+      return a.count / b.count;
+    }
+
+    friend constexpr Duration operator%(Duration a, Duration b) {
+      return Duration(Rep(a.count % b.count));
+    }
+
+    Duration &operator+=(Duration other) {
+      count += other.count;
+      return *this;
+    }
+
+    Duration &operator-=(Duration other) {
+      count -= other.count;
+      return *this;
+    }
+
+    friend constexpr bool operator==(Duration a, Duration b) {
+      return a.count == b.count;
+    }
+
+    friend constexpr bool operator!=(Duration a, Duration b) {
+      return a.count != b.count;
+    }
+
+    friend constexpr bool operator<(Duration a, Duration b) {
+      return a.count < b.count;
+    }
+
+    friend constexpr bool operator>(Duration a, Duration b) {
+      return a.count > b.count;
+    }
+
+    friend constexpr bool operator<=(Duration a, Duration b) {
+      return a.count <= b.count;
+    }
+
+    friend constexpr bool operator>=(Duration a, Duration b) {
+      return a.count >= b.count;
+    }
+
+    constexpr bool isZero() const {
+      return count == 0;
+    }
+  };
+
+  /** convert to any unit, truncating */
+  template<typename To, typename R, uint64_t N, uint64_t D> constexpr To durationCast(Duration<R, N, D> from) {
+    return To(Scale<N, D, To::num, To::den>::template apply<typename To::rep>(from.count));
+  }
+
+  using Nanos = Duration<uint64_t, 1, 1000000000>;
+  using Micros = Duration<uint32_t, 1, 1000000>;
+  using Millis = Duration<uint32_t, 1, 1000>;
+  using Seconds = Duration<uint32_t, 1, 1>;
+  /** for when 71 minutes of microseconds isn't enough */
+  using LongMicros = Duration<uint64_t, 1, 1000000>;
+
+  /** ticks of a clock running at @param Hz, for clocks whose rate is known at compile time */
+  template<uint64_t Hz, typename Rep = uint32_t> using Ticks = Duration<Rep, 1, Hz>;
+
+  template<typename Clock, typename Dur> struct TimePoint {
+    using duration = Dur;
+    using rep = typename Dur::rep;
+    using srep = std::make_signed_t<rep>;
+
+    Dur since;
+
+    constexpr TimePoint() = default;
+
+    constexpr explicit TimePoint(Dur since) : since(since) {}
+
+    friend constexpr Dur operator-(TimePoint a, TimePoint b) {
+      return a.since - b.since;
+    }
+
+    friend constexpr TimePoint operator+(TimePoint a, Dur d) {
+      return TimePoint(a.since + d);
+    }
+
+    friend constexpr TimePoint operator-(TimePoint a, Dur d) {
+      return TimePoint(a.since - d);
+    }
+
+    TimePoint &operator+=(Dur d) {
+      since += d;
+      return *this;
+    }
+
+    /** @returns signed amount by which a is after b */
+    static constexpr srep lead(TimePoint a, TimePoint b) {
+      return srep(rep(a.since.count - b.since.count));
+    }
+
+    friend constexpr bool operator==(TimePoint a, TimePoint b) {
+      return a.since == b.since;
+    }
+
+    friend constexpr bool operator!=(TimePoint a, TimePoint b) {
+      return a.since != b.since;
+    }
+
+    friend constexpr bool operator<(TimePoint a, TimePoint b) {
+      return lead(a, b) < 0;
+    }
+
+    friend constexpr bool operator>(TimePoint a, TimePoint b) {
+      return lead(a, b) > 0;
+    }
+
+    friend constexpr bool operator<=(TimePoint a, TimePoint b) {
+      return lead(a, b) <= 0;
+    }
+
+    friend constexpr bool operator>=(TimePoint a, TimePoint b) {
+      return lead(a, b) >= 0;
+    }
+  };
+
+  namespace literals {
+    constexpr Nanos operator""_ns(unsigned long long n) {
+      return Nanos(n);
+    }
+
+    constexpr Micros operator""_us(unsigned long long n) {
+      return Micros(uint32_t(n));
+    }
+
+    constexpr Millis operator""_ms(unsigned long long n) {
+      return Millis(uint32_t(n));
+    }
+
+    constexpr Seconds operator""_s(unsigned long long n) {
+      return Seconds(uint32_t(n));
+    }
+  }
+}
@@ -1,9 +1,15 @@
 #include "fifo.h"
 
 #include "core-atomic.h" // so that routines at different interrupt priorities can talk to each other using a fifo.
+#include <string.h> //memcpy
 
 Fifo::Fifo(unsigned quantity, unsigned char *mem) : mem(mem), end(mem + quantity), quantity(quantity) {
   clear();
+#if FIFO_STATS
+  stats = {};
+  baseline = {};
+  repeak = false;
+#endif
 }
 
 void Fifo::clear() {
@@ -21,13 +27,16 @@ void Fifo::wipe() {
 /** the following only accommodates a single writer thread, the atomicity only deals with read vs write. */
 int Fifo::attempt_insert(unsigned char incoming) {
   if (count >= quantity) {
+    noteFull();
     return -1;
   }
   *writer = incoming;
   if (atomic_increment(count)) {
+    noteInsertCollision();
     return -2;
   }
   incrementPointer(writer);
+  noteIn(1);
   return 0;
 } // Fifo::attempt_insert
 
@@ -47,9 +56,11 @@ int Fifo::attempt_remove() {
   unsigned pulled = *reader;
   // alter count before pointer to reduce the window for collision. (if we bail on collisions, else is moot)
   if (atomic_decrement(count)) {
+    noteRemoveCollision();
     return -2;
   }
   incrementPointer(reader);
+  noteOut(1);
   return int(pulled); //chars 128->255 are positive
 } // Fifo::attempt_remove
 
@@ -63,12 +74,75 @@ int Fifo::remove() {
 
 /** @returns how many did NOT get pushed */
 unsigned Fifo::stuff(const char *block, unsigned length) {
-  while (length-- > 0) {
-    if (!insert(*block++)) {
-      return ++length; //++ is to counter premature --
-    }
+  return length - write(reinterpret_cast<const unsigned char *>(block), length);
+}
+
+Fifo::Span Fifo::writableSpan() const {
+  unsigned room = free();
+  unsigned contiguous = end - writer;
+  return {writer, room < contiguous ? room : contiguous};
+}
+
+void Fifo::commitWrite(unsigned n) {
+  if (n == 0) {
+    return;
   }
-  return 0;
+  //data is already in place, count going up is what makes it visible to the reader.
+  while (atomic_add(count, n)) {
+    //a collision here just means the reader altered count, our add is still needed.
+    noteInsertCollision();
+  }
+  advancePointer(writer, n);
+  noteIn(n);
+}
+
+Fifo::Span Fifo::readableSpan() const {
+  unsigned present = available();
+  unsigned contiguous = end - reader;
+  return {reader, present < contiguous ? present : contiguous};
+}
+
+void Fifo::consume(unsigned n) {
+  if (n == 0) {
+    return;
+  }
+  while (atomic_add(count, -n)) {
+    //a collision here just means the writer altered count, our subtract is still needed.
+    noteRemoveCollision();
+  }
+  advancePointer(reader, n);
+  noteOut(n);
+}
+
+unsigned Fifo::write(const unsigned char *block, unsigned length) {
+  unsigned room = free();
+  if (length > room) {
+    length = room;
+    noteFull();
+  }
+  unsigned first = end - writer;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(writer, block, first);
+  memcpy(mem, block + first, length - first);//wrapped part, usually zero length
+  commitWrite(length);
+  return length;
+}
+
+unsigned Fifo::read(unsigned char *block, unsigned length) {
+  unsigned present = available();
+  if (length > present) {
+    length = present;
+  }
+  unsigned first = end - reader;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(block, reader, first);
+  memcpy(block + first, mem, length - first);
+  consume(length);
+  return length;
 }
 
 int Fifo::boundsError(bool reads) const {
@@ -89,3 +163,24 @@ int Fifo::boundsError(bool reads) const {
   }
   return 0; //strange, compiler didn't mention this missing return
 }
+
+FifoStats Fifo::statistics() const {
+#if FIFO_STATS
+  FifoStats snap = stats;
+  snap.fullRejections -= baseline.fullRejections;
+  snap.insertCollisions -= baseline.insertCollisions;
+  snap.removeCollisions -= baseline.removeCollisions;
+  snap.bytesIn -= baseline.bytesIn;
+  snap.bytesOut -= baseline.bytesOut;
+  return snap;
+#else
+  return {};
+#endif
+}
+
+void Fifo::resetStatistics() {
+#if FIFO_STATS
+  baseline = stats;
+  repeak = true;
+#endif
+}
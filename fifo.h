@@ -1,11 +1,31 @@
 #ifndef FIFO_H
 #define FIFO_H
 
-
+/** set FIFO_STATS to 1 project wide to have every Fifo keep occupancy and collision statistics, at a cost of about 52 bytes of ram per fifo and a few instructions per operation. */
+#ifndef FIFO_STATS
+#define FIFO_STATS 0
+#endif
+
+/** what a Fifo has been through since construction or the last resetStatistics(). All zeroes if FIFO_STATS is off. */
+struct FifoStats {
+  /** greatest number of bytes that were ever present at once */
+  unsigned peak;
+  /** inserts refused for lack of room, a block write that got truncated counts once */
+  unsigned fullRejections;
+  /** inserts that collided with the reader and had to be retried */
+  unsigned insertCollisions;
+  /** removes that collided with the writer and had to be retried */
+  unsigned removeCollisions;
+  unsigned bytesIn;
+  unsigned bytesOut;
+};
 
 /** a fifo suitable for one way data flow between routines running at different nvic priorities.
  * It only guards against read vs write conflicts, it does not deal with attempts to read nor write from more than one thread (as in two threads reading).
  * N.B.: we do not use std::atomic as its interface at the language level we are limiting ourselves to (c++17 as of this note) insists on blocking until success, we allow for 'fail and proceed'
+ * See FifoT in fifot.h for a version with no shared count, hence no collisions and no retries.
+ * See mpscfifo.h for queues that many isr's can write into.
+ * See recordqueue.h for whole messages rather than bytes.
  */
 class Fifo {
   unsigned count;
@@ -16,6 +36,57 @@ class Fifo {
   unsigned char * const end;
   const unsigned quantity;
 
+#if FIFO_STATS
+  /** each field is only altered by one side, writer or reader, so no atomics needed */
+  FifoStats stats;
+  /** what stats were at the last resetStatistics(), so that the isr side's counters never get written by another thread */
+  FifoStats baseline;
+  /** main loop asks the writer to restart peak tracking */
+  volatile bool repeak;
+#endif
+
+  //writer side tallies
+  void noteFull() {
+#if FIFO_STATS
+    ++stats.fullRejections;
+#endif
+  }
+
+  void noteInsertCollision() {
+#if FIFO_STATS
+    ++stats.insertCollisions;
+#endif
+  }
+
+  void noteIn(unsigned n) {
+#if FIFO_STATS
+    stats.bytesIn += n;
+    if (repeak) {
+      repeak = false;
+      stats.peak = count;
+    } else if (count > stats.peak) {
+      stats.peak = count;
+    }
+#else
+    (void) n;
+#endif
+  }
+
+  //reader side tallies
+  void noteRemoveCollision() {
+#if FIFO_STATS
+    ++stats.removeCollisions;
+#endif
+  }
+
+  void noteOut(unsigned n) {
+#if FIFO_STATS
+    stats.bytesOut += n;
+#else
+    (void) n;
+#endif
+  }
+
   /** circularly increment reader or writer */
   void incrementPointer(unsigned char *&pointer) const {
     if(++pointer == end) {//'>' is a COA while we're hunting for the fifo read error bug.
@@ -23,11 +94,25 @@ class Fifo {
     }
   }
 
+  /** advance reader or writer by @param n which must not exceed quantity */
+  void advancePointer(unsigned char *&pointer,unsigned n) const {
+    pointer += n;
+    if(pointer >= end) {
+      pointer -= quantity;
+    }
+  }
+
   /** copying doesn't make sense */
   Fifo(const Fifo&)=delete;
 public:
   Fifo(unsigned quantity,unsigned char *mem);
 
+  /** a contiguous piece of the fifo memory */
+  struct Span {
+    unsigned char *data;
+    unsigned length;
+  };
+
   /** forget the content */
   void clear();
 
@@ -59,8 +144,34 @@ public:
    /** @returns how many did NOT get pushed */
   unsigned stuff(const char *block,unsigned length);
 
+  /** writer side: @returns the contiguous empty region at the writer, which stops at the end of memory.
+   * Fill some of it then commitWrite() how much you filled. If the free space wraps call this again after the commit to get the rest. */
+  Span writableSpan() const;
+
+  /** writer side: publish @param n bytes placed into the region given by writableSpan() */
+  void commitWrite(unsigned n);
+
+  /** reader side: @returns the contiguous filled region at the reader, which stops at the end of memory.
+   * If the content wraps call this again after consume() to get the rest. */
+  Span readableSpan() const;
+
+  /** reader side: discard @param n bytes, typically those just processed from readableSpan() */
+  void consume(unsigned n);
+
+  /** copies as much of @param block as will fit, with a single update of the count. @returns how many got pushed. */
+  unsigned write(const unsigned char *block,unsigned length);
+
+  /** copies up to @param length bytes out to @param block, with a single update of the count. @returns how many were pulled.*/
+  unsigned read(unsigned char *block,unsigned length);
+
   /** @returns 0 for in bounds, 1 or -1 for outside of bounds.*/
   int boundsError(bool reads) const;
+
+  /** @returns counts since the last resetStatistics(), safe to call from any thread, each field is coherent but they aren't sampled at the same instant. */
+  FifoStats statistics() const;
+
+  /** restart counting, without writing to anything the isr side writes to. Peak restarts with the next insert. */
+  void resetStatistics();
 };
 
 /** allocate data and wrap it in a Fifo access mechanism.
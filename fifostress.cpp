@@ -0,0 +1,128 @@
+/*
+This commandline application checks FifoT with a real writer thread and a real reader thread, then compares its cost to Fifo's.
+
+The stress test pushes a sequence through a small FifoT so that it is full and empty over and over, the reader checks that nothing is lost, duplicated, or reordered.
+Run it under ThreadSanitizer as well, the publish/acquire pairing in FifoIndex is what it is checking:
+g++ -std=c++17 -O1 -g -fsanitize=thread -pthread fifostress.cpp fifo.cpp core-atomic.cpp stopwatch.cpp
+
+The throughput part times one insert plus one remove on a single thread with benchmark.h, then the two thread transfer rate of each fifo type.
+Fifo's two thread figure is only indicative, its reader and writer pointers are plain data that the host compiler is free to reorder, so leave it out of a sanitizer run with 'stress'.
+
+To build:
+g++ -std=c++17 -O2 -pthread fifostress.cpp fifo.cpp core-atomic.cpp stopwatch.cpp
+mv a.out fifostress
+
+fifostress [items] [stress]
+*/
+
+#include <cstdio>
+#include "stdlib.h"
+#include "string.h"
+#include <thread>
+#include <chrono>
+
+#include "fifot.h"
+#include "fifo.h"
+#include "benchmark.h"
+
+/** @returns number of errors seen by the reader */
+template<unsigned N> unsigned stress(unsigned items) {
+  FifoT<unsigned, N> fifo;
+  unsigned errors = 0;
+  unsigned fullSpins = 0;
+
+  std::thread writer([&] {
+    for (unsigned item = 0; item < items; ++item) {
+      while (!fifo.insert(item)) {
+        ++fullSpins;
+        std::this_thread::yield(); //else a single core host only switches threads on the timeslice
+      }
+    }
+  });
+
+  unsigned expected = 0;
+  while (expected < items) {
+    unsigned got;
+    if (fifo.remove(got)) {
+      if (got != expected) {
+        if (++errors < 10) {
+          printf("FifoT<%u>: expected %u got %u\n", N, expected, got);
+        }
+        expected = got;
+      }
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+  if (fifo.available() != 0) {
+    printf("FifoT<%u>: %u left over\n", N, fifo.available());
+    ++errors;
+  }
+  printf("FifoT<%u> %u items through, %u errors, writer found it full %u times\n", N, items, errors, fullSpins);
+  return errors;
+}
+
+/** @returns nanoseconds per byte to pass @param items through with one writer thread and one reader thread */
+template<typename Insert, typename Remove> double transfer(unsigned items, Insert insert, Remove remove) {
+  auto started = std::chrono::steady_clock::now();
+  std::thread writer([&] {
+    for (unsigned item = 0; item < items; ++item) {
+      while (!insert((unsigned char) item)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  unsigned sum = 0;
+  for (unsigned pulled = 0; pulled < items;) {
+    int got = remove();
+    if (got >= 0) {
+      sum += got;
+      ++pulled;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+  benchKeep(sum);
+  std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - started;
+  return took.count() / items;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned items = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000000;
+  bool stressOnly = argc > 2 && strcmp(argv[2], "stress") == 0;
+
+  unsigned errors = stress<4>(items) + stress<64>(items);
+  if (stressOnly) {
+    return errors ? 1 : 0;
+  }
+
+  FifoT<unsigned char, 64> ring;
+  FifoBuffer<64> bytes;
+  Benchmark<2000> bench(100, 16);
+  benchmarkReport("FifoT insert+remove", bench.run([&] {
+    unsigned char got;
+    ring.insert(42);
+    ring.remove(got);
+    benchKeep(got);
+  }));
+  benchmarkReport("Fifo insert+remove", bench.run([&] {
+    bytes.insert(42);
+    benchKeep(bytes.remove());
+  }));
+
+  printf("two threads, FifoT %6.1f ns per byte\n", transfer(items, [&](unsigned char c) {
+    return ring.insert(c);
+  }, [&]() -> int {
+    unsigned char got;
+    return ring.remove(got) ? got : -1;
+  }));
+  printf("two threads, Fifo  %6.1f ns per byte\n", transfer(items, [&](unsigned char c) {
+    return bytes.insert(c);
+  }, [&]() {
+    return bytes.remove();
+  }));
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+/** a fifo for one way data flow between exactly one writer and one reader running at different nvic priorities (or host threads).
+ * Unlike Fifo there is no shared count: the writer owns 'head' and the reader owns 'tail', each side only reads the other's index.
+ * As there is no read-modify-write on shared state there is never a collision and so never a retry, insert and remove either work or report full/empty.
+ *
+ * The indexes free run, they are masked only when touching the memory, hence the power of two size requirement.
+ * head - tail is the number of items present, even across the 2^32 rollover since N divides 2^32.
+ *
+ * Usage:
+ * FifoT<unsigned char,64> rxq;
+ * UART isr:  rxq.insert(dataByte);
+ * main loop: unsigned char c; while(rxq.remove(c)){ parse(c); }
+ */
+
+#if __linux__
+#include <atomic>  //host build is for stress testing with real threads, so we need real memory ordering.
+
+/** index that one thread writes and another reads */
+class FifoIndex {
+  std::atomic<unsigned> value{0};
+public:
+  /** read by the owner, who is the only writer so no ordering needed */
+  unsigned mine() const {
+    return value.load(std::memory_order_relaxed);
+  }
+
+  /** read by the other side, must see the data the owner wrote before it published */
+  unsigned theirs() const {
+    return value.load(std::memory_order_acquire);
+  }
+
+  /** owner announces new value, after the data it covers has been written or read */
+  void publish(unsigned newvalue) {
+    value.store(newvalue, std::memory_order_release);
+  }
+
+  /** read by the other side after it has copied data with seqRead(), to see whether the owner might have overwritten that data meanwhile.
+   * If the copy saw any of an overwrite then this sees the publish that preceded it, the acquire loads in seqRead() keep this load after them. */
+  unsigned recheck() const {
+    return value.load(std::memory_order_acquire);
+  }
+};
+
+/** for polled flags and headers living in plain arrays, where an array of std::atomic would not allow bulk access. */
+template<typename Scalar> void publishTo(Scalar &target, Scalar value) {
+  __atomic_store_n(&target, value, __ATOMIC_RELEASE);
+}
+
+template<typename Scalar> Scalar snapFrom(const Scalar &source) {
+  return __atomic_load_n(&source, __ATOMIC_ACQUIRE);
+}
+
+/** calls @param each with matching chunks of @param a and @param b, words if T allows else bytes. */
+template<typename T, typename A, typename B, typename Each> void seqChunks(A &a, B &b, Each each) {
+  if constexpr (sizeof(T) % sizeof(unsigned) == 0 && alignof(T) >= alignof(unsigned)) {
+    for (unsigned i = 0; i < sizeof(T) / sizeof(unsigned); ++i) {
+      each(reinterpret_cast<unsigned *>(&a)[i], reinterpret_cast<const unsigned *>(&b)[i]);
+    }
+  } else {
+    for (unsigned i = 0; i < sizeof(T); ++i) {
+      each(reinterpret_cast<unsigned char *>(&a)[i], reinterpret_cast<const unsigned char *>(&b)[i]);
+    }
+  }
+}
+
+/** seqlock style data, which a reader may be copying while the owner overwrites it, the reader finding out afterwards via recheck().
+ * Writer: release stores so that none of them can be seen ahead of the publish that announced the overwrite was coming,
+ * atomic so that the overlap is not a data race. That is the fence-free form of the pattern, which ThreadSanitizer understands. T must be trivially copyable. */
+template<typename T> void seqWrite(T &target, const T &value) {
+  seqChunks<T>(target, value, [](auto &to, const auto &from) {
+    __atomic_store_n(&to, from, __ATOMIC_RELEASE);
+  });
+}
+
+/** reader: acquire loads, so that if any of them saw an overwrite the recheck() that must follow sees the publish ahead of it. */
+template<typename T> void seqRead(T &target, const T &source) {
+  seqChunks<T>(target, source, [](auto &to, const auto &from) {
+    to = __atomic_load_n(&from, __ATOMIC_ACQUIRE);
+  });
+}
+
+#else
+
+/** index that one thread writes and another reads.
+ * On a single core cortexM an aligned 32 bit load or store is atomic and an isr sees memory in program order, so all we need is to keep the compiler from moving data accesses across the index access.
+ * The rp2040's second core would need a dmb in publish, do not share one of these across cores. */
+class FifoIndex {
+  volatile unsigned value = 0;
+public:
+  unsigned mine() const {
+    return value;
+  }
+
+  unsigned theirs() const {
+    unsigned snap = value;
+    __asm volatile("" ::: "memory");
+    return snap;
+  }
+
+  void publish(unsigned newvalue) {
+    __asm volatile("" ::: "memory");
+    value = newvalue;
+  }
+
+  unsigned recheck() const {
+    __asm volatile("" ::: "memory");
+    return value;
+  }
+};
+
+/** for polled flags and headers living in plain arrays, same reasoning as FifoIndex */
+template<typename Scalar> void publishTo(Scalar &target, Scalar value) {
+  __asm volatile("" ::: "memory");
+  *static_cast<volatile Scalar *>(&target) = value;
+}
+
+template<typename Scalar> Scalar snapFrom(const Scalar &source) {
+  Scalar snap = *static_cast<const volatile Scalar *>(&source);
+  __asm volatile("" ::: "memory");
+  return snap;
+}
+
+/** seqlock style data, see the host version. Here the writer only needs the compiler kept from moving the stores ahead of the previous publish. */
+template<typename T> void seqWrite(T &target, const T &value) {
+  __asm volatile("" ::: "memory");
+  target = value;
+}
+
+/** the barrier in the recheck() that follows keeps the copy ahead of it */
+template<typename T> void seqRead(T &target, const T &source) {
+  target = source;
+}
+#endif
+
+template<typename T, unsigned N> class FifoT {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "FifoT size must be a power of 2");
+  static constexpr unsigned mask = N - 1;
+
+  /** count of items ever inserted, only the writer alters it */
+  FifoIndex head;
+  /** count of items ever removed, only the reader alters it */
+  FifoIndex tail;
+  /** the memory*/
+  T mem[N];
+
+  /** copying doesn't make sense */
+  FifoT(const FifoT &) = delete;
+public:
+  // we allow mem content to be trash so that we can const construct the fifo.
+  FifoT() = default;
+
+  /** forget the content, only safe when neither side is active, such as during init. */
+  void clear() {
+    tail.publish(head.mine());
+  }
+
+  static constexpr unsigned size() {
+    return N;
+  }
+
+  /** @returns number of items present, but there may be more or less real soon. */
+  unsigned available() const {
+    return head.theirs() - tail.theirs();
+  }
+
+  /** @returns number of items empty, but there may be more or less real soon. */
+  unsigned free() const {
+    return N - available();
+  }
+
+  /** writer side: @returns whether there was room for @param incoming */
+  bool insert(const T &incoming) {
+    unsigned writer = head.mine();
+    if (writer - tail.theirs() >= N) {
+      return false;
+    }
+    mem[writer & mask] = incoming;
+    head.publish(writer + 1);
+    return true;
+  }
+
+  /** reader side: @returns whether there was an item, which is copied into @param outgoing */
+  bool remove(T &outgoing) {
+    unsigned reader = tail.mine();
+    if (head.theirs() == reader) {
+      return false;
+    }
+    outgoing = mem[reader & mask];
+    tail.publish(reader + 1);
+    return true;
+  }
+
+  /** reader side: @returns pointer to the oldest item without removing it, nullptr if empty. Valid until the next remove(). */
+  const T *peek() const {
+    unsigned reader = tail.mine();
+    if (head.theirs() == reader) {
+      return nullptr;
+    }
+    return &mem[reader & mask];
+  }
+
+  /** writer side: @returns how many did NOT get pushed */
+  unsigned stuff(const T *block, unsigned length) {
+    while (length > 0 && insert(*block)) {
+      ++block;
+      --length;
+    }
+    return length;
+  }
+
+  /** @returns whether item was actually pushed into the fifo */
+  bool operator=(const T &received) {
+    return insert(received);
+  }
+};
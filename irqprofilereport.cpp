@@ -0,0 +1,99 @@
+/*
+This commandline application ranks the per interrupt timing that nvic.cpp gathers when built with IRQ_PROFILE=1.
+
+Get the table off the target with gdb:
+dump binary value irqprofile.bin irqProfiles
+
+then:
+a.out irqprofile.bin [cycles per second]
+giving the rate adds microsecond columns.
+
+To build:
+g++ irqprofilereport.cpp
+mv a.out irqprofilereport
+
+The dump is little endian u32's: magic, slot count, 2 reserved, then per irq: sum (u64), count, min, max, last entry stamp.
+That is decoded byte by byte so that the host's struct packing doesn't matter.
+*/
+
+#include <cstdio>
+#include "stdlib.h"
+#include <vector>
+#include <algorithm>
+
+const unsigned Magic = 0x50515249;
+const unsigned HeaderBytes = 16;
+const unsigned SlotBytes = 24;
+
+struct Slot {
+  unsigned irq;
+  unsigned long long sum;
+  unsigned count;
+  unsigned min;
+  unsigned max;
+};
+
+unsigned word(const unsigned char *bytes) {
+  return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | unsigned(bytes[3]) << 24;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printf("usage: %s dumpfile [cycles per second]\n", argv[0]);
+    return 1;
+  }
+  FILE *dump = fopen(argv[1], "rb");
+  if (!dump) {
+    printf("can't open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<unsigned char> image;
+  int c;
+  while ((c = fgetc(dump)) != EOF) {
+    image.push_back(c);
+  }
+  fclose(dump);
+  double hz = argc > 2 ? atof(argv[2]) : 0;
+
+  if (image.size() < HeaderBytes || word(&image[0]) != Magic) {
+    printf("%s is not an irqProfiles dump\n", argv[1]);
+    return 1;
+  }
+  unsigned slots = word(&image[4]);
+  if (image.size() < HeaderBytes + slots * SlotBytes) {
+    printf("dump is truncated, header says %u slots\n", slots);
+    slots = (image.size() - HeaderBytes) / SlotBytes;
+  }
+
+  std::vector<Slot> used;
+  unsigned long long total = 0;
+  for (unsigned irq = 0; irq < slots; ++irq) {
+    const unsigned char *raw = &image[HeaderBytes + irq * SlotBytes];
+    Slot slot{irq, word(raw) | (unsigned long long)(word(raw + 4)) << 32, word(raw + 8), word(raw + 12), word(raw + 16)};
+    if (slot.count) {
+      used.push_back(slot);
+      total += slot.sum;
+    }
+  }
+  if (used.empty()) {
+    printf("no profiled interrupts have run\n");
+    return 0;
+  }
+  std::sort(used.begin(), used.end(), [](const Slot &a, const Slot &b) { return a.sum > b.sum; });
+
+  printf("irq\t   count\t     min\t     avg\t     max\t       total\t share%s\n", hz > 0 ? "\t  avg us\t  max us" : "");
+  for (const Slot &slot: used) {
+    double avg = double(slot.sum) / slot.count;
+    printf("%3u\t%8u\t%8u\t%8.1f\t%8u\t%12llu\t%5.1f%%", slot.irq, slot.count, slot.min, avg, slot.max, slot.sum, 100.0 * slot.sum / total);
+    if (hz > 0) {
+      printf("\t%8.2f\t%8.2f", avg * 1e6 / hz, slot.max * 1e6 / hz);
+    }
+    printf("\n");
+  }
+  printf("total cycles in profiled isrs: %llu", total);
+  if (hz > 0) {
+    printf(" (%.6f seconds)", total / hz);
+  }
+  printf("\n");
+  return 0;
+}
@@ -21,7 +21,7 @@ const unsigned ExpectedClock=12000000;
 const InputPin<PortNumber(0), BitNumber(4)> primePhase;//(/*BusLatch*/);
 const InputPin<0, 5> otherPhase;//(/*BusLatch*/);
 
-Irq<4> qeiPrimeIrq;
+IrqT<4> qeiPrimeIrq;
 
 int axis;
 // prime phase interrupt
@@ -7,7 +7,7 @@
 template <unsigned pinIndex> class PinIrq {
 public:
   StartSignal<pinIndex> starter;
-  Irq<pinIndex> nvic;
+  IrqT<pinIndex> nvic;
   /** configure polarity, @param andEnable is whether to also enable locally */
   void configure(bool rising, bool andEnable) const{
     starter.configure(rising,andEnable);
@@ -19,7 +19,7 @@ public:
   /** enable pin and at NVIC */
   void enable(bool on=true) const {
     starter.enable(on);
-    nvic.enable(on);
+    nvic = on;
   }
 
   /** reset/acknowledge/set to trigger again, often issued in an isr so keep it clean and fast. */
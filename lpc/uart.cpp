@@ -8,7 +8,7 @@
 #include "bitbasher.h" // for BitField
 #include "nvic.h"  // for isr
 
-const Irq<uartIrq> uirq;
+const IrqT<uartIrq> uirq;
 
 static unsigned sendings=0;
 static unsigned receptions=0;
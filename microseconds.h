@@ -4,6 +4,11 @@
 #include "Arduino.h"
 #endif
 
+#if __has_include(<type_traits>) //AVR's don't have a standard library
+#include "durations.h"
+#define MICROSECONDS_DURATIONS 1
+#endif
+
 /** POSIX versions uses time_t classes which 980F/safely wraps, we mimic that here.
   Note: we use double but AVR uses 32bit for that. */
 struct Microseconds {
@@ -28,6 +33,20 @@ struct Microseconds {
     return *this;
   }
 
+#if MICROSECONDS_DURATIONS
+  /** from any Time::Duration that is a whole number of microseconds, no double involved */
+  template<typename R, uint64_t N, uint64_t D, typename = std::enable_if_t<Time::Scale<N, D, 1, 1000000>::exact>>
+  Microseconds &operator = (Time::Duration<R, N, D> span) {
+    micros = (unsigned long)(Time::durationCast<Time::LongMicros>(span).count);
+    return *this;
+  }
+
+  /** unsigned long can be 64 bits, narrow to Time::Micros with durationCast if you must */
+  operator Time::LongMicros() const {
+    return Time::LongMicros(micros);
+  }
+#endif
+
 
   Microseconds& operator -=(const Microseconds &lesser) {
     micros -= lesser.micros;
@@ -57,12 +76,16 @@ struct Microseconds {
     if (interval.isZero()) {
       return 0;//gigo
     }
-    unsigned cycles = 0;
-    //we use repeated subtraction to do a divide since most times we cycle 0 or 1.
-    while (*this >= interval) {
-      *this -= interval;
-      ++cycles;
+    //most times we cycle 0 or 1, which costs a compare or two, only a late caller pays for a divide.
+    if (micros < interval.micros) {
+      return 0;
+    }
+    micros -= interval.micros;
+    if (micros < interval.micros) {
+      return 1;
     }
+    unsigned cycles = 1 + unsigned(micros / interval.micros);
+    micros %= interval.micros;
     return cycles;
   }
   
@@ -71,7 +94,7 @@ struct Microseconds {
   }
 
   bool operator >=(const Microseconds &that) const {
-    return micros > that.micros ;
+    return micros >= that.micros;
   }
   
   bool operator <(const Microseconds &that) const {
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "fifot.h"       //FifoIndex, publishTo, snapFrom
+#include "core-atomic.h" //atomic_compareAndSwap
+#include <stdint.h>
+#include <string.h>      //memcpy, memset
+
+/** fifos with many writers and one reader, for logging from isr's at different nvic priorities into one queue without masking interrupts.
+ *
+ * A writer claims space by compare-and-swap on the 'reserved' cursor, a collision means some other writer got in first so it just tries again with the new cursor.
+ * Having claimed space it fills it at leisure, then marks it as present. The reader only advances over contiguous present content,
+ * so a low priority writer that gets preempted between claim and mark merely delays the reader, it never blocks a higher priority writer.
+ *
+ * As with Fifo there may be only one reader.
+ */
+
+/** bytes, each claim of a block is contiguous in the output so messages from different isr's don't interleave.
+ * Each slot carries a lap marker beside the byte so that the reader can tell a freshly written byte from the stale one of the previous lap,
+ * which costs a second byte of ram per slot but saves the reader having to clear what it has read. */
+template<unsigned N> class MpscFifo {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "MpscFifo size must be a power of 2");
+  static constexpr unsigned mask = N - 1;
+
+  /** count of bytes ever claimed, altered only via compare-and-swap */
+  unsigned reserved = 0;
+  /** count of bytes ever removed, only the reader alters it */
+  FifoIndex tail;
+  /** low byte is data, bit 8 is the lap marker */
+  uint16_t slot[N] = {};
+
+  /** the first lap marks with 1 so that zeroed memory reads as empty */
+  static constexpr unsigned lapMark(unsigned index) {
+    return (((index / N) & 1) ^ 1) << 8;
+  }
+
+  /** @returns whether @param length slots were claimed, the first of which is put into @param start */
+  bool reserve(unsigned length, unsigned &start) {
+    unsigned claimed;
+    do {
+      claimed = snapFrom(reserved);
+      if (claimed + length - tail.theirs() > N) {
+        return false;
+      }
+    } while (atomic_compareAndSwap(reserved, claimed, claimed + length));
+    start = claimed;
+    return true;
+  }
+
+  MpscFifo(const MpscFifo &) = delete;
+public:
+  MpscFifo() = default;
+
+  /** @returns number of bytes claimed by writers and not yet removed, some of which might not yet be readable. */
+  unsigned available() const {
+    return snapFrom(reserved) - tail.theirs();
+  }
+
+  /** @returns number of bytes that can still be claimed, but there may be less real soon. */
+  unsigned free() const {
+    return N - available();
+  }
+
+  /** any thread: all or nothing, @returns how many did NOT get pushed, which is 0 or @param length */
+  unsigned stuff(const char *block, unsigned length) {
+    unsigned start;
+    if (!reserve(length, start)) {
+      return length;
+    }
+    for (unsigned i = 0; i < length; ++i) {
+      unsigned index = start + i;
+      publishTo(slot[index & mask], uint16_t(lapMark(index) | uint8_t(block[i])));
+    }
+    return 0;
+  }
+
+  /** any thread: @returns whether there was room */
+  bool insert(unsigned char incoming) {
+    return stuff(reinterpret_cast<const char *>(&incoming), 1) == 0;
+  }
+
+  /** reader only: @returns the byte, or -1 if there isn't one yet. */
+  int remove() {
+    unsigned reader = tail.mine();
+    unsigned pulled = snapFrom(slot[reader & mask]);
+    if ((pulled & ~0xFFu) != lapMark(reader)) {
+      return -1;
+    }
+    tail.publish(reader + 1);
+    return int(pulled & 0xFF);
+  }
+};
+
+/** length prefixed records, each stored contiguously so the reader gets a pointer to the whole thing.
+ * A record that would straddle the end of memory is preceded by a padding record that the reader skips.
+ * Content is word aligned, each record costs a one word header plus rounding up to a multiple of 4 bytes.
+ * The reader zeroes what it has consumed so that a header not yet written by a writer that has claimed space reads as 'not present'.
+ *
+ * Writer usage:
+ *   if(auto *payload=static_cast<Report *>(log.reserve(sizeof(Report)))){ payload->... ; log.commit(payload); }
+ * or log.push(&report,sizeof(report));
+ * Reader usage:
+ *   while(auto record=log.front()){ handle(record.data,record.length); log.pop(); }
+ */
+template<unsigned N> class MpscRecordQueue {
+  static_assert(N >= 8 && (N & (N - 1)) == 0, "MpscRecordQueue size must be a power of 2, and room for at least a header and a word");
+  static constexpr unsigned Words = N / 4;
+  static constexpr unsigned mask = Words - 1;
+
+  enum : unsigned {
+    Present = 1u << 31,
+    Padding = 1u << 30,
+    LengthMask = Padding - 1,
+  };
+
+  /** count of words ever claimed, altered only via compare-and-swap */
+  unsigned reserved = 0;
+  /** count of words ever removed, only the reader alters it */
+  FifoIndex tail;
+  unsigned mem[Words] = {};
+
+  static constexpr unsigned wordsFor(unsigned bytes) {
+    return (bytes + 3) / 4;
+  }
+
+  MpscRecordQueue(const MpscRecordQueue &) = delete;
+public:
+  MpscRecordQueue() = default;
+
+  /** what front() gives the reader, data is nullptr when there is nothing (yet) */
+  struct View {
+    const uint8_t *data;
+    unsigned length;
+
+    operator bool() const {
+      return data != nullptr;
+    }
+  };
+
+  /** any thread: @returns where to put @param length bytes, nullptr if there isn't room. Pass the pointer to commit() once filled. */
+  void *reserve(unsigned length) {
+    unsigned need = 1 + wordsFor(length);
+    unsigned claimed;
+    unsigned at;
+    unsigned pad;
+    do {
+      claimed = snapFrom(reserved);
+      at = claimed & mask;
+      pad = (at + need > Words) ? Words - at : 0;
+      if (claimed + pad + need - tail.theirs() > Words) {
+        return nullptr;
+      }
+    } while (atomic_compareAndSwap(reserved, claimed, claimed + pad + need));
+    if (pad) {
+      publishTo(mem[at], Present | Padding | pad);
+      at = 0;
+    }
+    publishTo(mem[at], length); //not yet Present, but the reader may already be polling this word
+    return &mem[at + 1];
+  }
+
+  /** any thread: mark a record gotten from reserve() as ready for the reader */
+  void commit(void *payload) {
+    unsigned &header = static_cast<unsigned *>(payload)[-1];
+    publishTo(header, header | Present);
+  }
+
+  /** any thread: all or nothing copy of @param length bytes at @param data, @returns whether there was room */
+  bool push(const void *data, unsigned length) {
+    void *payload = reserve(length);
+    if (!payload) {
+      return false;
+    }
+    memcpy(payload, data, length);
+    commit(payload);
+    return true;
+  }
+
+  /** reader only: @returns oldest record without removing it. */
+  View front() {
+    while (true) {
+      unsigned reader = tail.mine();
+      unsigned at = reader & mask;
+      unsigned header = snapFrom(mem[at]);
+      if (!(header & Present)) {
+        return {nullptr, 0};
+      }
+      if (!(header & Padding)) {
+        return {reinterpret_cast<const uint8_t *>(&mem[at + 1]), header & LengthMask};
+      }
+      unsigned pad = header & LengthMask;
+      memset(&mem[at], 0, pad * 4);
+      tail.publish(reader + pad);
+    }
+  }
+
+  /** reader only: discard the record that front() returned */
+  void pop() {
+    unsigned reader = tail.mine();
+    unsigned at = reader & mask;
+    unsigned header = mem[at];
+    if (!(header & Present)) {
+      return;
+    }
+    unsigned words = (header & Padding) ? (header & LengthMask) : 1 + wordsFor(header & LengthMask);
+    memset(&mem[at], 0, words * 4);
+    tail.publish(reader + words);
+  }
+};
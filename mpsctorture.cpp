@@ -0,0 +1,243 @@
+/*
+This commandline application hammers MpscFifo and MpscRecordQueue with many writer threads and one reader, then compares the cost of a lock-free insert to that of Fifo::insert with a lock around it.
+
+Each writer sends a numbered sequence tagged with its own id, the reader checks that every writer's sequence arrives complete, in order, and that no message got mixed with another's.
+A small queue is used so that writers collide on the claim and find it full a lot, which is what the test is for. Run it under ThreadSanitizer too:
+g++ -std=c++17 -O1 -g -fsanitize=thread -pthread mpsctorture.cpp fifo.cpp core-atomic.cpp stopwatch.cpp
+
+On a target the lock would be masking interrupts, here a spinlock stands in for that. Its uncontended cost is near what cpsid/cpsie cost, contended it is what a writer at the same priority would suffer.
+
+To build:
+g++ -std=c++17 -O2 -pthread mpsctorture.cpp fifo.cpp core-atomic.cpp stopwatch.cpp
+mv a.out mpsctorture
+
+mpsctorture [writers] [messages per writer] [torture]
+*/
+
+#include <cstdio>
+#include "stdlib.h"
+#include "string.h"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "mpscfifo.h"
+#include "fifo.h"
+#include "benchmark.h"
+
+/** what each writer sends, the check word is so that the reader can tell a torn message from a whole one */
+struct Message {
+  unsigned writer;
+  unsigned sequence;
+  unsigned check;
+
+  static unsigned checkFor(unsigned writer, unsigned sequence) {
+    return ~(writer * 0x9E3779B9u ^ sequence);
+  }
+};
+
+/** tallies what the reader got from each writer */
+class Tally {
+  std::vector<unsigned> next;
+public:
+  unsigned errors = 0;
+
+  explicit Tally(unsigned writers) : next(writers, 0) {}
+
+  void note(const char *which, const Message &msg) {
+    if (msg.writer >= next.size() || msg.check != Message::checkFor(msg.writer, msg.sequence)) {
+      if (++errors < 10) {
+        printf("%s: torn message %u:%u:%08X\n", which, msg.writer, msg.sequence, msg.check);
+      }
+      return;
+    }
+    if (msg.sequence != next[msg.writer]) {
+      if (++errors < 10) {
+        printf("%s: writer %u expected %u got %u\n", which, msg.writer, next[msg.writer], msg.sequence);
+      }
+    }
+    next[msg.writer] = msg.sequence + 1;
+  }
+
+  unsigned received() const {
+    unsigned sum = 0;
+    for (unsigned got: next) {
+      sum += got;
+    }
+    return sum;
+  }
+};
+
+/** runs @param writers threads each calling @param send for every message until it works, while this thread calls @param receive until all have arrived.
+ * @returns how many times a writer found no room */
+template<typename Send, typename Receive> unsigned torture(unsigned writers, unsigned messages, Send send, Receive receive) {
+  std::atomic<unsigned> fullSpins{0};
+  std::vector<std::thread> threads;
+  for (unsigned id = 0; id < writers; ++id) {
+    threads.emplace_back([&, id] {
+      for (unsigned sequence = 0; sequence < messages; ++sequence) {
+        Message msg = {id, sequence, Message::checkFor(id, sequence)};
+        while (!send(msg)) {
+          fullSpins.fetch_add(1, std::memory_order_relaxed);
+          std::this_thread::yield(); //else a single core host only switches threads on the timeslice
+        }
+      }
+    });
+  }
+  for (unsigned pending = writers * messages; pending > 0;) {
+    if (receive()) {
+      --pending;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  return fullSpins;
+}
+
+unsigned tortureRecords(unsigned writers, unsigned messages) {
+  static MpscRecordQueue<128> queue;
+  Tally tally(writers);
+  unsigned full = torture(writers, messages, [](const Message &msg) {
+    //alternate the two ways of writing, reserve/commit leaves a window between claim and mark for others to get into
+    if (msg.sequence & 1) {
+      return queue.push(&msg, sizeof(msg));
+    }
+    auto *payload = static_cast<Message *>(queue.reserve(sizeof(msg)));
+    if (!payload) {
+      return false;
+    }
+    *payload = msg;
+    queue.commit(payload);
+    return true;
+  }, [&] {
+    auto record = queue.front();
+    if (!record) {
+      return false;
+    }
+    Message msg;
+    if (record.length != sizeof(msg)) {
+      ++tally.errors;
+      printf("MpscRecordQueue: record of %u bytes\n", record.length);
+    }
+    memcpy(&msg, record.data, sizeof(msg));
+    queue.pop();
+    tally.note("MpscRecordQueue", msg);
+    return true;
+  });
+  printf("MpscRecordQueue<128>: %u writers, %u messages received, %u errors, found full %u times\n", writers, tally.received(), tally.errors, full);
+  return tally.errors;
+}
+
+unsigned tortureBytes(unsigned writers, unsigned messages) {
+  static MpscFifo<64> fifo;
+  Tally tally(writers);
+  unsigned full = torture(writers, messages, [](const Message &msg) {
+    return fifo.stuff(reinterpret_cast<const char *>(&msg), sizeof(msg)) == 0;
+  }, [&] {
+    //the whole message was claimed at once so it is contiguous, but its bytes become readable one at a time
+    Message msg;
+    auto *bytes = reinterpret_cast<unsigned char *>(&msg);
+    for (unsigned i = 0; i < sizeof(msg);) {
+      int got = fifo.remove();
+      if (got >= 0) {
+        bytes[i++] = got;
+      } else if (i == 0) {
+        return false;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    tally.note("MpscFifo", msg);
+    return true;
+  });
+  printf("MpscFifo<64>: %u writers, %u messages received, %u errors, found full %u times\n", writers, tally.received(), tally.errors, full);
+  return tally.errors;
+}
+
+/** stands in for masking interrupts around Fifo::insert */
+class SpinLock {
+  std::atomic_flag held = ATOMIC_FLAG_INIT;
+public:
+  void lock() {
+    while (held.test_and_set(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() {
+    held.clear(std::memory_order_release);
+  }
+};
+
+/** @returns nanoseconds per byte for @param writers threads to each insert @param bytes with @param insert while this thread removes them with @param remove */
+template<typename Insert, typename Remove> double contended(unsigned writers, unsigned bytes, Insert insert, Remove remove) {
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned id = 0; id < writers; ++id) {
+    threads.emplace_back([&, id] {
+      for (unsigned count = 0; count < bytes; ++count) {
+        while (!insert((unsigned char) id)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (unsigned pending = writers * bytes; pending > 0;) {
+    if (remove() >= 0) {
+      --pending;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - started;
+  return took.count() / (writers * bytes);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned writers = argc > 1 ? strtoul(argv[1], nullptr, 0) : 4;
+  unsigned messages = argc > 2 ? strtoul(argv[2], nullptr, 0) : 200000;
+  bool tortureOnly = argc > 3 && strcmp(argv[3], "torture") == 0;
+
+  unsigned errors = tortureRecords(writers, messages) + tortureBytes(writers, messages);
+  if (tortureOnly) {
+    return errors ? 1 : 0;
+  }
+
+  static MpscFifo<64> lockFree;
+  static FifoBuffer<64> masked;
+  SpinLock mask;
+
+  Benchmark<2000> bench(100, 16);
+  benchmarkReport("MpscFifo insert+remove", bench.run([&] {
+    lockFree.insert(42);
+    benchKeep(lockFree.remove());
+  }));
+  benchmarkReport("locked Fifo insert+remove", bench.run([&] {
+    mask.lock();
+    masked.insert(42);
+    mask.unlock();
+    benchKeep(masked.remove());
+  }));
+
+  printf("%u writers, MpscFifo     %6.1f ns per byte\n", writers, contended(writers, messages, [&](unsigned char c) {
+    return lockFree.insert(c);
+  }, [&] {
+    return lockFree.remove();
+  }));
+  printf("%u writers, locked Fifo  %6.1f ns per byte\n", writers, contended(writers, messages, [&](unsigned char c) {
+    mask.lock();
+    bool fit = masked.insert(c);
+    mask.unlock();
+    return fit;
+  }, [&] {
+    return masked.remove();
+  }));
+  return errors ? 1 : 0;
+}
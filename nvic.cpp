@@ -4,7 +4,6 @@
 #include "peripheraltypes.h"
 #include "cruntime.h"
 
-constexpr unsigned PriorityShift=4;//todo: this '4' is ST's value, may need to make dependent upon processor defines.
 // volatile unsigned CriticalSection::nesting = 0;
 /////////////////////////////////
 
@@ -23,6 +22,11 @@ void configurePriorityGrouping(unsigned code){
   SFRint<unsigned,SCB(0x0C)>()= ((~code & 7) << 8) | (0x05FA<<16); //5FA is a guard against random writes.
 }
 
+#if SPURIOUS_IRQ_STATS
+/** @returns whether the irq should be disabled */
+static bool noteSpuriousIrq(unsigned irq);
+#endif
+
 extern "C" { // to keep names simple for "alias" processor
   void unhandledFault(void){
     unsigned num = SFRfield<SCB(0x04),0,9>();
@@ -79,6 +83,11 @@ extern "C" { // to keep names simple for "alias" processor
   void unhandledInterruptHandler(void) {//#used by linker's vctor table support.
     /* turn it off so it doesn't happen again, and also is a handy breakpoint */
     unsigned num = SFRfield<SCB(0x04),0,9>();
+#if SPURIOUS_IRQ_STATS
+    if (!noteSpuriousIrq(num - 16)) {
+      return;//rate limiter is tolerating it
+    }
+#endif
     disableInterrupt(num - 16);
   }
 } // end extern "C"
@@ -126,6 +135,60 @@ Handler FaultTable[] __attribute__((section(".vectors.2"))) = {//0 is stack top,
 //if the following table doesn't exist use mkIrqs to build it for your processor
 
 #include "nvicTable.inc" //this table is expected in parent directory as it is project specific.
+
+const unsigned IrqCount = countof(VectorTable);
+
+#if SPURIOUS_IRQ_STATS
+static SpuriousIrq spuriousIrqs[countof(VectorTable)];
+
+__attribute__((weak)) u32 spuriousIrqStamp() {
+#if defined(__linux__) || (defined(__CORTEX_M) && __CORTEX_M < 3)
+  return 0;
+#else
+  return *reinterpret_cast<volatile u32 *>(0xE0001004); //DWT CYCCNT
+#endif
+}
+
+static bool noteSpuriousIrq(unsigned irq) {
+  if (irq >= countof(spuriousIrqs)) {
+    return true;
+  }
+  SpuriousIrq &record = spuriousIrqs[irq];
+  u32 now = spuriousIrqStamp();
+  if (record.count++ == 0) {
+    record.first = now;
+  }
+  record.last = now;
+  if (record.inWindow == 0 || now - record.windowStart >= SPURIOUS_IRQ_WINDOW) {
+    record.windowStart = now;
+    record.inWindow = 0;
+  }
+  if (record.inWindow < 0xFFFF) {
+    ++record.inWindow;
+  }
+  record.disabled = record.inWindow > SPURIOUS_IRQ_LIMIT;
+  return record.disabled;
+}
+
+const SpuriousIrq *spuriousIrq(unsigned irq) {
+  return irq < countof(spuriousIrqs) ? &spuriousIrqs[irq] : nullptr;
+}
+
+unsigned nextSpuriousIrq(unsigned from) {
+  for (unsigned irq = from; irq < countof(spuriousIrqs); ++irq) {
+    if (spuriousIrqs[irq].count) {
+      return irq;
+    }
+  }
+  return ~0u;
+}
+
+void clearSpuriousIrqs() {
+  for (unsigned irq = countof(spuriousIrqs); irq-- > 0;) {
+    spuriousIrqs[irq] = {};
+  }
+}
+#endif
 /* nvicTable.inc is creatable by the cortexm/mkIrqs script which is invoked by the CMake setup included in 980f cortexm repo.
  * The file above creates names for interrupts using the Irqname( ) macro where the argument must be a preprocessor resolved decimal number.
  * Instead of dedicated names for each interrupt request you name your isr whatever pleases you then mention that it is a strong reference to Irqname( xx).
@@ -173,6 +236,36 @@ void Irq::setAllPriorties(u8 prio) {
 // }
 /*@} end of CMSIS_Core_NVICFunctions */
 
+#if IRQ_PROFILE
+#if defined(__CORTEX_M) && __CORTEX_M < 3
+#error "IRQ_PROFILE needs the DWT cycle counter, which M0's don't have"
+#endif
+
+IrqProfileTable irqProfiles = {IrqProfileTable::Magic, IRQ_PROFILE_SLOTS, {0, 0}, {}};
+unsigned irqProfileNested = 0;
+
+IrqStamp::~IrqStamp() {
+  u32 nested = *static_cast<volatile unsigned *>(&irqProfileNested) - nestedAtEntry;
+  u32 inclusive = irqProfileStamp() - entry;
+  u32 exclusive = inclusive - nested;
+  while (atomic_add(irqProfileNested, exclusive)) {
+    //a handler that preempted us finished meanwhile
+  }
+  if (number < IRQ_PROFILE_SLOTS) {//only this irq touches its slot, and it can't preempt itself
+    IrqProfile &stats = irqProfiles.slot[number];
+    if (stats.count == 0 || exclusive < stats.min) {
+      stats.min = exclusive;
+    }
+    if (exclusive > stats.max) {
+      stats.max = exclusive;
+    }
+    stats.sum += exclusive;
+    ++stats.count;
+    stats.lastEntry = entry;
+  }
+}
+#endif
+
 #ifdef __linux__ //just compiling for syntax checking
 bool IRQEN;
 #else
@@ -47,13 +47,87 @@
    isrcode();
  }
 */
+/** set IRQ_PROFILE to 1 project wide to have every HandleInterrupt/ObjectInterrupt handler time itself into irqProfiles, M3 and up only.
+ * The DWT cycle counter must be running, CycleClock::start() does that.
+ * Times are exclusive: time spent in a profiled handler that preempted another is subtracted from the one it preempted.
+ * Read the table with the debugger, or dump it (gdb: dump binary value irqprofile.bin irqProfiles) and run irqprofilereport on the file.
+ */
+#ifndef IRQ_PROFILE
+#define IRQ_PROFILE 0
+#endif
+
+/** irq numbers at or above this are not profiled, the default covers most parts */
+#ifndef IRQ_PROFILE_SLOTS
+#define IRQ_PROFILE_SLOTS 96
+#endif
+
+#if IRQ_PROFILE
+/** layout is read by irqprofilereport, change both together */
+struct IrqProfile {
+  u64 sum;
+  u32 count;
+  u32 min;
+  u32 max;
+  /** cycle counter at the most recent entry */
+  u32 lastEntry;
+};
+
+struct IrqProfileTable {
+  enum : u32 {
+    Magic = 0x50515249  //"IRQP" in a little endian dump
+  };
+  u32 magic;
+  u32 slots;
+  u32 reserved[2];
+  IrqProfile slot[IRQ_PROFILE_SLOTS];
+};
+
+extern IrqProfileTable irqProfiles;
+/** cycles spent in profiled handlers that have finished, a preempted handler subtracts what this grew by while it was preempted */
+extern unsigned irqProfileNested;
+
+inline u32 irqProfileStamp() {
+#ifdef __linux__ //just compiling for syntax checking
+  return 0;
+#else
+  return *reinterpret_cast<volatile u32 *>(0xE0001004); //DWT CYCCNT, inline as a call would be part of what it measures
+#endif
+}
+
+/** lives for the duration of a profiled handler, its destructor does the accounting.
+ * The stamp is taken before the nested total is sampled, and at exit after, so that a handler that preempts between the two reads
+ * is counted as ours (a small overstatement) rather than subtracted without its time having been included (an underflow). */
+class IrqStamp {
+  const unsigned number;
+  const u32 entry;//members are initialized in declaration order, this one must come first
+  const u32 nestedAtEntry;
+public:
+  explicit IrqStamp(unsigned number) :
+    number(number), entry(irqProfileStamp()), nestedAtEntry(*static_cast<volatile unsigned *>(&irqProfileNested)) {}
+
+  ~IrqStamp();
+};
+
+//the body you write becomes a static function that the real handler wraps.
+#define HandleInterrupt(irqname) \
+  static void MACRO_cat(IrqBody, irqname)(); \
+  void IrqName(irqname)() { IrqStamp stamp(irqname); MACRO_cat(IrqBody, irqname)(); } \
+  static void MACRO_cat(IrqBody, irqname)()
+#else
 #define HandleInterrupt(irqname)  void IrqName( irqname ) ()
+#endif
+
+/** for the common one line handler that calls a method on a driver object: ObjectInterrupt(theRTC->isr(), 41) */
+#define ObjectInterrupt(objectcall, irqname) HandleInterrupt(irqname) { objectcall; }
 
 #define FaultName(faultIndex) MACRO_cat(FAULT , faultIndex)
 #define FaultHandler(name, faultIndex) void name() __attribute__((alias("FAULT" # faultIndex)))
 
 #define HandleFault(faultIndex) void FaultName(faultIndex) ()
 
+/** priorities here are 0..15 with 0 the most urgent, the hardware registers get them shifted up by this */
+constexpr unsigned PriorityShift=4;//todo: this '4' is ST's value, may need to make dependent upon processor defines.
+
 //there are 16 possible faults, address space is always reserved for them whether the particular chip has the fault or not.
 constexpr unsigned FaultBias=16;
 
@@ -65,6 +139,61 @@ u8 setInterruptPriorityFor(int exceptionnumber, u8 newvalue);
 
 extern "C" void disableInterrupt(unsigned irqnum);
 
+/** what the vector table has for irqs nobody handles, disables the irq that got it there */
+extern "C" void unhandledInterruptHandler(void);
+
+/** number of irq entries in the flash table, from nvicTable.inc */
+extern const unsigned IrqCount;
+
+/** set SPURIOUS_IRQ_STATS to 1 to have unhandledInterruptHandler keep a record per vector of interrupts that nobody handles.
+ * Then an irq that went silent can be found without a debugger: iterate with nextSpuriousIrq() and report what spuriousIrq() gives.
+ */
+#ifndef SPURIOUS_IRQ_STATS
+#define SPURIOUS_IRQ_STATS 0
+#endif
+
+/** with SPURIOUS_IRQ_STATS: how many unhandled interrupts a vector may take within SPURIOUS_IRQ_WINDOW before it is disabled.
+ * 0 disables on the first, as is done without SPURIOUS_IRQ_STATS. A one-off is then tolerated while a storm still gets shut off. */
+#ifndef SPURIOUS_IRQ_LIMIT
+#define SPURIOUS_IRQ_LIMIT 0
+#endif
+
+/** in spuriousIrqStamp() units, the default is about a quarter second of DWT cycles at 72MHz */
+#ifndef SPURIOUS_IRQ_WINDOW
+#define SPURIOUS_IRQ_WINDOW (1u << 24)
+#endif
+
+#if SPURIOUS_IRQ_STATS
+struct SpuriousIrq {
+  /** total unhandled interrupts */
+  u32 count;
+  /** spuriousIrqStamp() of the first and most recent ones */
+  u32 first;
+  u32 last;
+  /** start of the present rate limit window */
+  u32 windowStart;
+  /** how many in the present window */
+  u16 inWindow;
+  /** whether the rate limiter (or the lack of one) has disabled it */
+  bool disabled;
+};
+
+/** timestamp for the records, DWT cycles on M3 and up (0 if the counter hasn't been started), always 0 on M0.
+ * Define your own to use some other clock, such as the system tick. */
+u32 spuriousIrqStamp();
+
+/** @returns the record for @param irq, nullptr if it is beyond the vector table.
+ * Each record is only updated by its own interrupt, a copy made while that is happening might be a mix of the old and the new. */
+const SpuriousIrq *spuriousIrq(unsigned irq);
+
+/** @returns the lowest irq number at or above @param from that has taken an unhandled interrupt, ~0 if none do.
+ * for(unsigned irq=nextSpuriousIrq(0); irq!=~0u; irq=nextSpuriousIrq(irq+1)) report(irq, *spuriousIrq(irq)); */
+unsigned nextSpuriousIrq(unsigned from);
+
+/** forget all records, does not re-enable anything */
+void clearSpuriousIrqs();
+#endif
+
 /** #of levels for grouping priorities, max 7
  * <sup>7-code</sup> is what actually goes into the hardware register (==~code)
  * stm32F10x et al. only implements the 4 msbs of the logic so values 3,2,1 are same as 0 */
@@ -73,8 +202,8 @@ void configurePriorityGrouping(unsigned code);
 /** Controls for an irq, which involves bit picking in a block of 32 bit registers.
  * all internals are const so you may use const on every instance, helps the compiler optimize access.
  * Also being intrinsically const you can have multiple copies with no threading issues.
- templated version was too difficult to manage for the slight potential gain in efficiency, i.e. templating was creeping through classes that didn't template well and a base class that the template can extend adds greater runtime overhead than the template can remove.
- Instead we just inline the code as a template would have required of us and let the compiler work at optimizing this. */
+ * Use this when the number is only known at runtime, such as in a driver shared by several instances of a peripheral, or when a class would otherwise have to become a template just to carry the number.
+ * When the number is a compile time constant use IrqT (below), it has the same operations with every address and mask a constant. */
 class Irq {
 public:
 
@@ -174,6 +303,92 @@ public:
   }
 };
 
+/** an irq whose number is known at compile time, every address and mask is a constant so each operation is a load of two immediates and a store.
+ * Instances are empty, use one as a member or a local at no cost, or just call the static functions: IrqT<uartIrq>::enable().
+ * Use the runtime Irq when the number is only known at runtime, such as a driver shared by several instances of a peripheral.
+ */
+template<unsigned number> class IrqT {
+public:
+  static constexpr unsigned Number = number;
+  static constexpr unsigned bias = Irq::biasFor(number);
+  static constexpr unsigned mask = bitMask(Irq::bitFor(number));
+
+  /** this is for the registers where you write a 1 to a bit to make something happen. */
+  template<unsigned grup> static void strobe() {
+    SFRint<unsigned, bias + grup>() = mask;
+  }
+
+  template<unsigned grup> static bool irqflag() {
+    return (mask & SFRint<unsigned, bias + grup>()) != 0;
+  }
+
+  /** unlike Irq::setPriority this doesn't read back the old value, so that it is a single store */
+  static void setPriority(u8 newvalue) {
+    SFRint<u8, 0xE000'E400 + number>() = newvalue << PriorityShift;
+  }
+
+  static u8 priority() {
+    return SFRint<u8, 0xE000'E400 + number>() >> PriorityShift;
+  }
+
+  /** @returns whether the source of the request is active */
+  static bool isActive() {
+    return irqflag<0x300>();
+  }
+
+  /** @returns whether the request is pending */
+  static bool isPending() {
+    return irqflag<0x200>();
+  }
+
+  /** @returns whether the individual enable is active */
+  static bool isEnabled() {
+    return irqflag<0x100>();
+  }
+
+  static void enable() {
+    strobe<0x100>();
+  }
+
+  /** simulate the interrupt, expect it to be handled before the next line of your code. */
+  static void fake() {
+    strobe<0x200>();
+  }
+
+  static void clear() {
+    strobe<0x280>();
+  }
+
+  static void disable() {
+    strobe<0x180>();
+  }
+
+  /** for some devices you must acknowledge a prior interrupt before enabling */
+  static void prepare() {
+    clear();
+    enable();
+  }
+
+  /** enable or disable */
+  void operator=(bool on) const { // NOLINT(cppcoreguidelines-c-copy-assignment-signature,misc-unconventional-assign-operator)
+    if (on) {
+      enable();
+    } else {
+      disable();
+    }
+  }
+
+  /** @returns whether the interrupt is enabled, NOT the state of the request. */
+  operator bool() const { // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+    return isEnabled();
+  }
+
+  /** for passing to things that take the runtime kind */
+  static constexpr Irq dynamic() {
+    return Irq(number);
+  }
+};
+
 #include "core-atomic.h"
 
 /** tool for managing disabling an interrupt in a nesting fashion, ie a function that needs to disable the interrupt can call another
@@ -189,8 +404,8 @@ public:
   }
 
   void enable() {
-    if (atomic_decrementNowZero(locker)) {//todo:000 seems to be defective!
-      enable();
+    if (atomic_decrementNowZero(locker)) {
+      Irq::enable();//# explicit base call, this function hides it and recursing here was the old defect.
       // if locked then reduce the lock such that the unlock will cause an enable
       // one level earlier than it would have. This might be surprising so an
       // unmatched unlock might be the best enable.(so we renamed this method to 'enable' ;)
@@ -279,6 +494,7 @@ inline bool IrqEnable;
 #define LOCK(somename) CriticalSection somename ## _locker
 
 /** creating one of these in a function (or blockscope) disables <em> all </em> interrupts until said function (or blockscope) exits.
+ * That includes ones that don't share anything with the code being protected, @see PriorityCeiling for blocking only those that do.
  * By using this fanciness you can't accidentally leave interrupts disabled.
  * We don't have to use atomic operations on 'nesting' as this object physically stops any threads other than the one that constructs it.
  */
@@ -303,3 +519,82 @@ public:
   }
 };
 
+/** creating one of these in a blockscope masks all interrupts until the block exits, then puts PRIMASK back as it was.
+ * Unlike CriticalSection and a bare IrqEnable=false/true pair it doesn't unmask on exit if the caller already had interrupts masked, so it is fine inside an isr or another guard.
+ * The barriers keep the compiler from moving the guarded accesses out of the block, which IrqEnable alone doesn't. */
+class InterruptMask {
+#if defined(__linux__)
+public:
+  InterruptMask() {}
+#else
+  const unsigned wasMasked;
+public:
+  InterruptMask() : wasMasked(PRIMASK) {
+    IrqEnable = false;
+    __asm volatile("" ::: "memory");
+  }
+
+  ~InterruptMask() {
+    __asm volatile("" ::: "memory");
+    PRIMASK = wasMasked;
+  }
+#endif
+  InterruptMask(const InterruptMask &) = delete;
+};
+
+/** an Irq whose priority is known at compile time, so that ceilings can be computed from it:
+ * constexpr PrioritizedIrq stepIrq(28, 0), encoderIrq(23, 1), uartIrq(37, 5);
+ */
+class PrioritizedIrq : public Irq {
+public:
+  const u8 priority;
+
+  constexpr PrioritizedIrq(unsigned number, u8 priority) : Irq(number), priority(priority) {}
+
+  /** put the priority into the nvic */
+  void applyPriority() const {
+    setPriority(priority);
+  }
+};
+
+/** @returns the priority that blocks all of the given irqs, the most urgent of them */
+constexpr u8 priorityCeiling(const PrioritizedIrq &irq) {
+  return irq.priority;
+}
+
+template<typename... More> constexpr u8 priorityCeiling(const PrioritizedIrq &irq, const More &... more) {
+  return irq.priority < priorityCeiling(more...) ? irq.priority : priorityCeiling(more...);
+}
+
+/** creating one of these in a blockscope masks interrupts at priority @param ceiling and below (numerically at or above) until the block exits.
+ * More urgent interrupts still run, use it for data shared between handlers that are all at the ceiling or less urgent than it:
+ *
+ * PriorityCeiling<priorityCeiling(encoderIrq, uartIrq)> lock;
+ *
+ * Costs a read and a write of BASEPRI on the way in and a write on the way out. Nesting works, an inner guard with a less urgent ceiling doesn't lower the mask.
+ * Priority 0 can't be a ceiling since BASEPRI of 0 means no masking, use CriticalSection for data the most urgent handlers share.
+ * M0's don't have BASEPRI so there this masks everything, as InterruptMask does.
+ */
+template<u8 ceiling> class PriorityCeiling {
+  static_assert(ceiling > 0 && ceiling < (1 << (8 - PriorityShift)), "ceiling must be 1..15, 0 can't be masked by BASEPRI");
+#if defined(__linux__)
+public:
+  PriorityCeiling() {}
+#elif defined(__CORTEX_M) && __CORTEX_M < 3
+  InterruptMask mask;
+public:
+  PriorityCeiling() {}
+#else
+  const unsigned was;
+public:
+  PriorityCeiling() : was(BASEPRI) {
+    BASEPRI.raise(ceiling << PriorityShift);
+  }
+
+  ~PriorityCeiling() {
+    BASEPRI = was;
+  }
+#endif
+  PriorityCeiling(const PriorityCeiling &) = delete;
+};
+
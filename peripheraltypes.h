@@ -44,11 +44,30 @@ union AddressCaster {
   }
 };
 
+/** set PERIPHERAL_SIMULATION to 1 in a host build to have all of the classes herein access a simulated register space, @see simulatedbus.h */
+#ifndef PERIPHERAL_SIMULATION
+#define PERIPHERAL_SIMULATION 0
+#endif
+
+#if PERIPHERAL_SIMULATION
+#include "simulatedbus.h"
+
+/** what the classes below hold to get at their register */
+template<typename Scalar> using BusRef = SimulatedRegister<Scalar>;
+
+template<typename Scalar> constexpr SimulatedRegister<Scalar> Ref(Address address) {
+  return SimulatedRegister<Scalar>(address);
+}
+#else
+/** what the classes below hold to get at their register */
+template<typename Scalar> using BusRef = volatile Scalar &;
+
 /* this function exists to hide some verbose casting */
 template<typename Scalar> constexpr Scalar &Ref(Address address) {
   AddressCaster pun{address};
   return *static_cast<Scalar *>(pun.pointer);
 }
+#endif
 
 
 /** A 32 bit item at a known address.
@@ -56,7 +75,7 @@ template<typename Scalar> constexpr Scalar &Ref(Address address) {
  * This class essentially wraps the Ref<> template with operator overloads */
 class ControlWord {
 protected:
-  volatile unsigned &item;
+  BusRef<unsigned> item;
 
 public:
   explicit constexpr ControlWord(Address dynaddr) : item(Ref<unsigned>(dynaddr)) {
@@ -100,7 +119,7 @@ public:
 
 template<class Mustbe32> struct ControlStruct {
 protected:
-  volatile unsigned &item;
+  BusRef<unsigned> item;
 
 public:
   explicit constexpr ControlStruct(Address dynaddr) : item(Ref<unsigned>(dynaddr)) {
@@ -128,7 +147,7 @@ public:
  * This is for fields which are byte aligned and some multiple of 8 bits */
 template<typename IntType> class ControlItem {
 protected:
-  volatile IntType &item;
+  BusRef<IntType> item;
 
 public:
   explicit constexpr ControlItem(Address dynaddr) : item(Ref<IntType>(dynaddr)) {
@@ -169,7 +188,7 @@ public:
  * Note: 'volatile' isn't used here as it is gratuitous when the variable isn't nominally read multiple times in a function.
  */
 class ControlField {
-  volatile unsigned &word;
+  BusRef<unsigned> word;
 
   /** mask gets pre-positioned */
   const unsigned mask;
@@ -209,7 +228,7 @@ public:
  *  This is NOT derived from ControlField as we can do some optimizations that the compiler might miss (or developer might have disabled) */
 
 class ControlBool : public BoolishRef {
-  volatile unsigned &word;
+  BusRef<unsigned> word;
   /** mask gets pre-positioned */
   const unsigned mask;
   const unsigned pos;
@@ -0,0 +1,97 @@
+#include "ramvectors.h"
+#include "wtf.h"
+
+using namespace RamVectors;
+
+static Handler ramTable[Count] __attribute__((aligned(Alignment)));
+
+/** context for vectors that have been bind()'ed */
+static struct Binding {
+  BoundCall call;
+  void *context;
+} bindings[RAM_VECTOR_IRQS];
+
+/** where VTOR pointed before install(), what detach() restores from.
+ * 0 is a real table, it is VTOR's reset value and where most parts alias flash, so whether install() has run is kept separately. */
+static uintptr_t flashTable = 0;
+static bool copied = false;
+
+static SFRint<const Handler *, 0xE000'ED08> VTOR;
+
+/** entry @param vector of the table install() copied, read through an address so that a table at 0 isn't a null pointer to the compiler */
+static Handler flashEntry(unsigned vector) {
+  return *reinterpret_cast<const volatile Handler *>(flashTable + vector * sizeof(Handler));
+}
+
+static void barrier() {
+#ifndef __linux__
+  __asm volatile("dsb\n\tisb" ::: "memory");
+#endif
+}
+
+/** every bound vector points here, the active exception number picks the binding */
+RAMCODE static void dispatchBound() {
+#ifdef __linux__
+  unsigned active = SFRfield<SCB(0x04), 0, 9>();
+#else
+  unsigned active = IPSR & 0x1FF; //cheaper than the same thing from ICSR
+#endif
+  const Binding &binding = bindings[active - FaultBias];
+  binding.call(binding.context);
+}
+
+bool RamVectors::installed() {
+  return VTOR == ramTable;
+}
+
+void RamVectors::install() {
+  if (installed()) {
+    return;
+  }
+  if (IrqCount > RAM_VECTOR_IRQS) {
+    //the nvic would fetch the higher vectors from past the end of ramTable, raise RAM_VECTOR_IRQS for this part.
+    while (true) {
+      wtf(IrqCount);
+    }
+  }
+  flashTable = reinterpret_cast<uintptr_t>(static_cast<const Handler *>(VTOR));
+  copied = true;
+  unsigned existing = FaultBias + IrqCount;
+  for (unsigned vector = Count; vector-- > 0;) {
+    ramTable[vector] = vector < existing ? flashEntry(vector) : unhandledInterruptHandler;
+  }
+  barrier(); //table must be complete before the switch
+  VTOR = ramTable;
+  barrier(); //and the switch complete before we return and perhaps enable something
+}
+
+Handler RamVectors::attach(unsigned irq, Handler handler) {
+  if (irq >= RAM_VECTOR_IRQS) {
+    return nullptr;
+  }
+  install();
+  Handler &entry = ramTable[FaultBias + irq];
+  Handler previous = entry;
+  entry = handler; //single word store, an interrupt between here and the barrier sees one or the other
+  barrier();
+  return previous;
+}
+
+void RamVectors::detach(unsigned irq) {
+  if (irq < RAM_VECTOR_IRQS && copied) {
+    attach(irq, irq < IrqCount ? flashEntry(FaultBias + irq) : unhandledInterruptHandler);
+  }
+}
+
+void RamVectors::bind(unsigned irq, BoundCall call, void *context) {
+  if (irq >= RAM_VECTOR_IRQS) {
+    return;
+  }
+  {
+    const Irq gate(irq);
+    IRQstacker lock(gate); //the pair must not be seen half changed if it is already bound
+    bindings[irq].call = call;
+    bindings[irq].context = context;
+  }
+  attach(irq, dispatchBound);
+}
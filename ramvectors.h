@@ -0,0 +1,80 @@
+#pragma once
+
+#include "nvic.h"
+
+/**
+A copy of the vector table in sram so that handlers can be chosen at runtime, without a hand written HandleInterrupt stub per driver instance.
+
+RamVectors::install() copies whatever table is active and points VTOR at the copy, attach() then replaces entries.
+For an object known at compile time attach<theObject, &Driver::isr>(irq) uses a trampoline generated for that pair, which the compiler reduces to a single branch into the method.
+For objects and capturing lambdas only known at runtime bind() stores a context per vector and the entry becomes a shared dispatcher that looks up the active vector in IPSR.
+A captureless lambda converts to a Handler, attach(irq, [](){...}) costs nothing extra.
+
+The table is a plain static array so it lands in .bss, in SRAM. The NVIC can't fetch vectors from the F407's CCM.
+
+Hot handlers can be marked RAMCODE to run from sram, zero wait state where flash has them. They are copied along with initialized data by cstartup.
+The F407's CCM can't fetch instructions either so this is sram too. The linker inserts veneers for calls between flash and sram.
+
+  Uart console(2);
+  RamVectors::attach<console, &Uart::isr>(console.irq.number);
+  RamVectors::bind(28, someLambdaThatLivesForever);
+*/
+
+/** how many irq's the ram table has room for, beyond the 16 faults. Must be at least the part's IrqCount, install() hangs calling wtf() if it isn't. */
+#ifndef RAM_VECTOR_IRQS
+#define RAM_VECTOR_IRQS 96
+#endif
+
+#define RAMCODE __attribute__((section(".data.ramcode"), noinline))
+
+namespace RamVectors {
+  constexpr unsigned Count = FaultBias + RAM_VECTOR_IRQS;
+
+  /** VTOR needs the table aligned to a power of two at least as big as the table, and at least 128 */
+  constexpr unsigned alignmentFor(unsigned bytes, unsigned power = 128) {
+    return power >= bytes ? power : alignmentFor(bytes, power * 2);
+  }
+
+  constexpr unsigned Alignment = alignmentFor(Count * sizeof(Handler));
+
+  /** copy the active table to ram and point VTOR at the copy, harmless to repeat */
+  void install();
+
+  /** @returns whether VTOR is pointing at the ram copy */
+  bool installed();
+
+  /** set the handler for @param irq, installing the ram table if that hasn't happened yet.
+   * @returns the previous handler, nullptr if the irq is beyond the table and nothing was done */
+  Handler attach(unsigned irq, Handler handler);
+
+  /** go back to what the flash table has for @param irq */
+  void detach(unsigned irq);
+
+  template<auto &object, auto method> void trampoline() {
+    (object.*method)();
+  }
+
+  /** @param object and @param method fixed at compile time, the entry is a function that is just a branch into the method */
+  template<auto &object, auto method> Handler attach(unsigned irq) {
+    return attach(irq, &trampoline<object, method>);
+  }
+
+  using BoundCall = void (*)(void *context);
+
+  /** for objects only known at runtime, @param call gets @param context each time @param irq happens */
+  void bind(unsigned irq, BoundCall call, void *context);
+
+  /** @param callable (a functor or a capturing lambda) must outlive the binding */
+  template<typename Callable> void bind(unsigned irq, Callable &callable) {
+    bind(irq, [](void *context) {
+      (*static_cast<Callable *>(context))();
+    }, &callable);
+  }
+
+  /** a method on an object that is only known at runtime */
+  template<typename T, void (T::*method)()> void bind(unsigned irq, T &object) {
+    bind(irq, [](void *context) {
+      (static_cast<T *>(context)->*method)();
+    }, &object);
+  }
+}
@@ -0,0 +1,94 @@
+#include "recordqueue.h"
+
+#include <string.h> //memcpy
+
+/** header value that tells the reader to go back to the start of memory, can't be a real length */
+constexpr unsigned Padding = ~0u;
+
+static constexpr unsigned wordsFor(unsigned bytes) {
+  return (bytes + 3) / 4;
+}
+
+RecordQueue::RecordQueue(unsigned quantity, void *mem) : pending(0), mem(static_cast<unsigned *>(mem)), words(quantity / 4) {
+  clear();
+}
+
+void RecordQueue::clear() {
+  head.publish(0);
+  tail.publish(0);
+  pending = 0;
+}
+
+bool RecordQueue::isEmpty() const {
+  return head.theirs() == tail.theirs();
+}
+
+void *RecordQueue::reserve(unsigned length) {
+  if (length / 4 >= words) {
+    return nullptr;//can never fit, and rejecting it here keeps 'need' from overflowing and the header from reading as Padding
+  }
+  unsigned need = 1 + wordsFor(length);
+  unsigned writer = head.mine();
+  unsigned reader = tail.theirs();
+  unsigned at = writer;
+  if (writer >= reader) {
+    unsigned tillEnd = words - writer;
+    //filling to the very end is ok unless that makes head land on tail
+    if (need > tillEnd || (need == tillEnd && reader == 0)) {
+      if (need >= reader) {
+        return nullptr;
+      }
+      at = 0;
+    }
+  } else if (need >= reader - writer) {
+    return nullptr;
+  }
+  if (at != writer) {
+    mem[writer] = Padding;//reader can't see this until commit.
+  }
+  pending = at;
+  mem[at] = length;
+  return &mem[at + 1];
+} // RecordQueue::reserve
+
+bool RecordQueue::commit(unsigned length) {
+  if (length > mem[pending]) {
+    return false;//caller overran what it reserved, we'd rather lose the record than trust it.
+  }
+  mem[pending] = length;
+  unsigned next = pending + 1 + wordsFor(length);
+  head.publish(next == words ? 0 : next);
+  return true;
+}
+
+bool RecordQueue::push(const void *data, unsigned length) {
+  void *payload = reserve(length);
+  if (!payload) {
+    return false;
+  }
+  memcpy(payload, data, length);
+  return commit(length);
+}
+
+RecordQueue::View RecordQueue::front() const {
+  unsigned reader = tail.mine();
+  if (reader == head.theirs()) {
+    return {nullptr, 0};
+  }
+  if (mem[reader] == Padding) {
+    reader = 0;
+  }
+  return {reinterpret_cast<const unsigned char *>(&mem[reader + 1]), mem[reader]};
+}
+
+void RecordQueue::pop() {
+  unsigned reader = tail.mine();
+  if (reader == head.theirs()) {
+    return;
+  }
+  if (mem[reader] == Padding) {
+    reader = 0;
+  }
+  unsigned next = reader + 1 + wordsFor(mem[reader]);
+  tail.publish(next == words ? 0 : next);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "fifot.h" //FifoIndex
+
+/** a fifo of length prefixed records, for one writer and one reader running at different nvic priorities.
+ * Each record is stored contiguously so the reader gets a pointer to the whole thing rather than re-parsing a byte stream,
+ * and a whole record is produced or consumed with a single index update.
+ * A record that won't fit before the end of memory goes to the start, leaving a padding marker that the reader skips.
+ *
+ * Content is word aligned, each record costs a one word header plus rounding up to a multiple of 4 bytes.
+ * One word is always left unused so that head==tail can only mean empty.
+ *
+ * Writer usage:
+ *   if(auto *frame=static_cast<uint8_t *>(q.reserve(MaxFrame))){ unsigned got=receive(frame); q.commit(got); }
+ * or q.push(&report,sizeof(report));
+ * Reader usage:
+ *   while(auto record=q.front()){ handle(record.data,record.length); q.pop(); }
+ */
+class RecordQueue {
+  /** word index of where the next record goes, only the writer alters it */
+  FifoIndex head;
+  /** word index of the oldest record, only the reader alters it */
+  FifoIndex tail;
+  /** writer's private note of where the record it reserved begins */
+  unsigned pending;
+  /** the memory*/
+  unsigned * const mem;
+  /** size of mem in words */
+  const unsigned words;
+
+  /** copying doesn't make sense */
+  RecordQueue(const RecordQueue &) = delete;
+public:
+  /** @param quantity is in bytes, @param mem must be word aligned */
+  RecordQueue(unsigned quantity, void *mem);
+
+  /** what front() gives the reader, data is nullptr when there is nothing */
+  struct View {
+    const unsigned char *data;
+    unsigned length;
+
+    operator bool() const {
+      return data != nullptr;
+    }
+  };
+
+  /** forget the content, only safe when neither side is active, such as during init. */
+  void clear();
+
+  /** @returns whether there is at least one record */
+  bool isEmpty() const;
+
+  /** writer side: @returns where to put up to @param length bytes, nullptr if there isn't room or @param length is more than the whole memory. Follow with commit(). */
+  void *reserve(unsigned length);
+
+  /** writer side: publish the record from the last reserve(), @param length may be less than what was reserved but not more.
+   * @returns false if it was more, in which case nothing is published and the reservation is abandoned, as what was written past it can't be trusted. */
+  bool commit(unsigned length);
+
+  /** writer side: copy @param length bytes from @param data as one record, @returns whether there was room */
+  bool push(const void *data, unsigned length);
+
+  /** reader side: @returns oldest record without removing it, valid until pop() */
+  View front() const;
+
+  /** reader side: discard the oldest record */
+  void pop();
+};
+
+/** allocate data and wrap it in a RecordQueue access mechanism. @param size is in bytes */
+template<unsigned size> class RecordBuffer : public RecordQueue {
+public:
+  unsigned buf[(size + 3) / 4];
+  // we allow buf content to be trash so that we can const construct the queue.
+  RecordBuffer() : RecordQueue(sizeof(buf), buf) {}
+};
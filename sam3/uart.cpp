@@ -179,7 +179,7 @@ void Uart::reception(bool enabled) const {
 
 void Uart::irq(bool enabled) const {
 //nvic interrupt:
-  Irq<UartPid>irq;
+  IrqT<UartPid> irq;
   irq=enabled;
 }
 
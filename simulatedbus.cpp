@@ -0,0 +1,114 @@
+#include "simulatedbus.h"
+
+#include <map>
+#include <vector>
+
+namespace SimulatedBus {
+  struct Register {
+    uint32_t value = 0;
+    Counts counts = {0, 0};
+  };
+
+  struct Hook {
+    Address first;
+    Address last;
+    ReadHook onRead;
+    WriteHook onWrite;
+    void *context;
+  };
+
+  /** keyed by word address, a map so that the report comes out in address order */
+  static std::map<Address, Register> registers;
+  static std::vector<Hook> hooks;
+
+  static Address wordOf(Address address) {
+    return address & ~3u;
+  }
+
+  /** @returns the most recently added hook that covers @param address and has the wanted kind of function, nullptr if none */
+  template<typename Fn> static const Hook *hookFor(Address address, Fn Hook::*which) {
+    for (auto hook = hooks.rbegin(); hook != hooks.rend(); ++hook) {
+      if (address >= hook->first && address <= hook->last && (*hook).*which) {
+        return &*hook;
+      }
+    }
+    return nullptr;
+  }
+
+  /** @returns mask for a @param bytes wide access at @param address, positioned within its word */
+  static uint32_t laneMask(Address address, unsigned bytes) {
+    uint32_t mask = bytes >= 4 ? ~0u : ((1u << (8 * bytes)) - 1);
+    return mask << (8 * (address & 3));
+  }
+
+  void hook(Address first, Address last, ReadHook onRead, WriteHook onWrite, void *context) {
+    hooks.push_back({first, last, onRead, onWrite, context});
+  }
+
+  uint32_t read(Address address, unsigned bytes) {
+    Register &reg = registers[wordOf(address)];
+    ++reg.counts.reads;
+    uint32_t word = reg.value;
+    if (auto hook = hookFor(address, &Hook::onRead)) {
+      word = (*hook->onRead)(wordOf(address), word, hook->context);
+    }
+    return (word & laneMask(address, bytes)) >> (8 * (address & 3));
+  }
+
+  void write(Address address, uint32_t value, unsigned bytes) {
+    Register &reg = registers[wordOf(address)];
+    ++reg.counts.writes;
+    uint32_t mask = laneMask(address, bytes);
+    uint32_t word = (reg.value & ~mask) | ((value << (8 * (address & 3))) & mask);
+    if (auto hook = hookFor(address, &Hook::onWrite)) {
+      word = (*hook->onWrite)(wordOf(address), word, reg.value, hook->context);
+    }
+    reg.value = word;
+  }
+
+  uint32_t peek(Address address) {
+    auto found = registers.find(wordOf(address));
+    return found != registers.end() ? found->second.value : 0;
+  }
+
+  void poke(Address address, uint32_t value) {
+    registers[wordOf(address)].value = value;
+  }
+
+  Counts counts(Address address) {
+    auto found = registers.find(wordOf(address));
+    return found != registers.end() ? found->second.counts : Counts{0, 0};
+  }
+
+  Counts total() {
+    Counts sum = {0, 0};
+    for (const auto &reg: registers) {
+      sum.reads += reg.second.counts.reads;
+      sum.writes += reg.second.counts.writes;
+    }
+    return sum;
+  }
+
+  void resetCounts() {
+    for (auto &reg: registers) {
+      reg.second.counts = {0, 0};
+    }
+  }
+
+  void reset() {
+    registers.clear();
+    hooks.clear();
+  }
+
+  void report(FILE *out) {
+    fprintf(out, "register  \treads\twrites\tvalue\n");
+    for (const auto &reg: registers) {
+      const Counts &counts = reg.second.counts;
+      if (counts.all()) {
+        fprintf(out, "0x%08X\t%5u\t%6u\t0x%08X\n", reg.first, counts.reads, counts.writes, reg.second.value);
+      }
+    }
+    Counts sum = total();
+    fprintf(out, "total     \t%5u\t%6u\n", sum.reads, sum.writes);
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+a simulated peripheral address space, for running drivers on a host and counting what they cost in bus transactions.
+
+Build with PERIPHERAL_SIMULATION=1 (host only) and every access made via peripheraltypes.h (Ref<>, ControlWord, ControlItem, ControlField, ControlBool, SFRint, SFRfield, SFRbit)
+goes through read() and write() here instead of to an address. Registers spring into existence at 0 the first time they are touched.
+Accesses made via raw pointer casts or structs laid over peripheral memory are not seen.
+
+A hook on a range of addresses models behaviour: status bits that read as set, write-1-to-clear flags, a data register that feeds a test's buffer.
+
+Every access counts against the 32 bit word it lands in, a read-modify-write such as |= counts one of each, as it costs on the real bus.
+
+  SimulatedBus::reset();
+  uart.setParams(115200, 8, 'N', 1);
+  printf("setParams: %u transactions\n", SimulatedBus::total().all());
+  SimulatedBus::report(stdout);
+*/
+
+namespace SimulatedBus {
+  using Address = unsigned; //same as peripheraltypes.h
+
+  /** @returns what the read gets given @param stored, the present content of the register */
+  using ReadHook = uint32_t (*)(Address address, uint32_t stored, void *context);
+  /** @returns what gets stored given @param value being written over @param previous */
+  using WriteHook = uint32_t (*)(Address address, uint32_t value, uint32_t previous, void *context);
+
+  struct Counts {
+    unsigned reads;
+    unsigned writes;
+
+    unsigned all() const {
+      return reads + writes;
+    }
+  };
+
+  /** model @param first through @param last (inclusive) with the given hooks, either of which may be nullptr. Later hooks take precedence over earlier ones that overlap. */
+  void hook(Address first, Address last, ReadHook onRead, WriteHook onWrite, void *context = nullptr);
+
+  /** what peripheraltypes.h calls, @param bytes is 1, 2 or 4 */
+  uint32_t read(Address address, unsigned bytes);
+
+  void write(Address address, uint32_t value, unsigned bytes);
+
+  /** for tests to look at or set a whole register without counting and without hooks */
+  uint32_t peek(Address address);
+
+  void poke(Address address, uint32_t value);
+
+  /** @returns the counts for the register containing @param address */
+  Counts counts(Address address);
+
+  /** @returns the sum over all registers */
+  Counts total();
+
+  /** zero the counts, leaving the register contents and hooks alone. Use between operations being measured. */
+  void resetCounts();
+
+  /** forget all registers, counts, and hooks */
+  void reset();
+
+  /** one line per register that has been accessed since the counts were reset, by address */
+  void report(FILE *out);
+}
+
+/** stands in for a volatile reference to a register, what Ref<> gives when simulating */
+template<typename Scalar> class SimulatedRegister {
+  SimulatedBus::Address address;
+public:
+  explicit constexpr SimulatedRegister(SimulatedBus::Address address) : address(address) {}
+
+  constexpr SimulatedRegister(const SimulatedRegister &other) = default;
+
+  operator Scalar() const {
+    return Scalar(SimulatedBus::read(address, sizeof(Scalar)));
+  }
+
+  const SimulatedRegister &operator=(Scalar value) const {
+    SimulatedBus::write(address, uint32_t(value), sizeof(Scalar));
+    return *this;
+  }
+
+  /** copies the value, as assigning one volatile reference to another would */
+  const SimulatedRegister &operator=(const SimulatedRegister &other) const {
+    return operator=(Scalar(other));
+  }
+
+  const SimulatedRegister &operator|=(Scalar bits) const {
+    return operator=(Scalar(Scalar(*this) | bits));
+  }
+
+  const SimulatedRegister &operator&=(Scalar bits) const {
+    return operator=(Scalar(Scalar(*this) & bits));
+  }
+};
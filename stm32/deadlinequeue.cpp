@@ -0,0 +1,105 @@
+#include "deadlinequeue.h"
+
+void DeadlineQueue::init(unsigned hz, u8 priority) {
+  hw.init(int(hz));
+  hw.setCycler(0x10000); //free run through all 16 bits, the update interrupt extends it.
+  hw.update(); //load the prescaler now rather than at the first rollover
+  hw.cc.setmode(0); //compare only sets the flag, doesn't touch the pin
+  hw.cc.IE(false);
+  hw.UIE = 1;
+  upper = 0;
+  hw.irq.setPriority(priority);
+  hw.Interrupts(true);
+  hw.startRunning(); //clears the update event that update() made.
+}
+
+u32 DeadlineQueue::now() const {
+  while (true) {
+    u32 high = upper;
+    u16 low = hw.counter();
+    bool wrapped = hw.UIF; //rolled over but the isr hasn't counted it yet
+    if (wrapped) {
+      low = hw.counter(); //reread in case the first read was just before the wrap
+    }
+    if (high == upper) {
+      return (wrapped ? high + 0x10000 : high) | low;
+    }
+  }
+}
+
+void DeadlineQueue::link(Deadline &d) {
+  Deadline **cursor = &head;
+  //after any due at the same time, so equal deadlines run in the order they were scheduled.
+  while (*cursor && s32((*cursor)->due - d.due) <= 0) {
+    cursor = &(*cursor)->next;
+  }
+  d.next = *cursor;
+  *cursor = &d;
+  d.pending = true;
+}
+
+void DeadlineQueue::unlink(Deadline &d) {
+  for (Deadline **cursor = &head; *cursor; cursor = &(*cursor)->next) {
+    if (*cursor == &d) {
+      *cursor = d.next;
+      break;
+    }
+  }
+  d.next = nullptr;
+  d.pending = false;
+}
+
+void DeadlineQueue::program() {
+  if (!head) {
+    hw.cc.IE(false);
+    return;
+  }
+  //only the low 16 bits are compared, a deadline further out than that costs a harmless interrupt per rollover.
+  hw.cc.setTicks(head->due);
+  hw.cc.clear();
+  hw.cc.IE(true);
+  if (s32(head->due - now()) <= 0) {
+    hw.cc.Update(); //it may have gone by while we were setting it, have the hardware raise the event anyway
+  }
+}
+
+void DeadlineQueue::scheduleAt(Deadline &d, u32 due) {
+  IRQstacker lock(hw.irq);
+  if (d.pending) {
+    unlink(d);
+  }
+  d.due = due;
+  link(d);
+  if (head == &d) {
+    program();
+  }
+}
+
+void DeadlineQueue::cancel(Deadline &d) {
+  IRQstacker lock(hw.irq);
+  if (d.pending) {
+    bool wasFirst = head == &d;
+    unlink(d);
+    if (wasFirst) {
+      program();
+    }
+  }
+}
+
+void DeadlineQueue::isr() {
+  if (hw.UIF) {
+    //a higher priority now() between these two would count the rollover twice
+    InterruptMask masked;
+    upper = upper + 0x10000;
+    hw.UIF = 0;
+  }
+  if (hw.cc.happened()) {
+    hw.cc.clear();
+    while (head && s32(head->due - now()) <= 0) {
+      Deadline &d = *head;
+      unlink(d);
+      d.onDue(); //might reschedule itself
+    }
+    program();
+  }
+}
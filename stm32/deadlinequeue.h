@@ -0,0 +1,94 @@
+#pragma once
+
+#include "timer.h"
+
+/**
+many deadlines served by one hardware compare, no polling.
+
+Pending deadlines are kept in a list sorted by due time, the compare unit is set to the earliest one and its interrupt runs whatever is due.
+The timer free runs over its full 16 bits and the update interrupt extends that to 32, deadlines can be up to 2^31 ticks out.
+Comparisons are by signed difference so the 32 bit wrap is harmless.
+
+Use a timer whose update and compare events share an interrupt, which is 2 through 5 on the F10x. Tick rate is whatever you init() with, 1MHz gives microsecond deadlines.
+
+Usage:
+  const DelayTimer deadlineHw(2, 1);//timer 2, compare 1
+  DeadlineQueue deadlines(deadlineHw);
+  HandleInterrupt(28){ deadlines.isr(); }
+  ...
+  deadlines.init(1000000, 2);
+  DeadlineCall blink([](){ led.toggle(); });
+  deadlines.scheduleIn(blink, 250);//250 us from now
+*/
+
+class Deadline {
+  friend class DeadlineQueue;
+  Deadline *next = nullptr;
+  volatile bool pending = false;
+protected:
+  /** called from the timer isr when due */
+  virtual void onDue() = 0;
+public:
+  /** timer count at which it is due, meaningful while pending and in onDue() where it is handy for scheduling the next one without drift. */
+  u32 due = 0;
+
+  /** @returns whether it is scheduled and hasn't happened yet */
+  bool isPending() const {
+    return pending;
+  }
+
+  virtual ~Deadline() = default;
+};
+
+/** a deadline that calls a function, for when a class of your own is overkill */
+class DeadlineCall : public Deadline {
+  void (*action)();
+protected:
+  void onDue() override {
+    action();
+  }
+
+public:
+  explicit DeadlineCall(void (*action)()) : action(action) {}
+};
+
+class DeadlineQueue {
+  const DelayTimer &hw;
+  /** upper 16 bits of the count, bumped by the update interrupt */
+  volatile u32 upper = 0;
+  /** earliest first */
+  Deadline *head = nullptr;
+
+  /** set the compare for the head of the list, or turn it off if there is none */
+  void program();
+
+  void link(Deadline &d);
+
+  void unlink(Deadline &d);
+
+public:
+  explicit DeadlineQueue(const DelayTimer &hw) : hw(hw) {}
+
+  /** set up and start the timer, ticking at @param hz, with the interrupt at @param priority */
+  void init(unsigned hz, u8 priority);
+
+  /** @returns 32 bit count of timer ticks, consistent across the 16 bit rollover even when called with the timer interrupt pending */
+  u32 now() const;
+
+  /** (re)schedule @param d for when the count reaches @param due, which must be less than 2^31 ticks from now. Past due runs asap. */
+  void scheduleAt(Deadline &d, u32 due);
+
+  void scheduleIn(Deadline &d, u32 ticks) {
+    scheduleAt(d, now() + ticks);
+  }
+
+  template<typename R, u64 N, u64 D> void scheduleIn(Deadline &d, Time::Duration<R, N, D> span) {
+    scheduleIn(d, hw.ticksFor(span));
+  }
+
+  /** unschedule, harmless if not pending */
+  void cancel(Deadline &d);
+
+  /** to be called from the timer's isr */
+  void isr();
+};
@@ -29,11 +29,16 @@ Hertz Timer::baseRate() const {
 }
 
 unsigned Timer::ticksForMillis(unsigned ms) const {
-  return ticksForSeconds(1e-3*ms);
+  return ticksForLongMicros(u64(ms) * 1000);
 }
 
 unsigned Timer::ticksForMicros(unsigned us) const {
-  return ticksForSeconds(1e-6*us);
+  return ticksForLongMicros(us);
+}
+
+unsigned Timer::ticksForLongMicros(u64 micros) const {
+  u64 perTick = u64(1000000) * (1 + PSC);
+  return unsigned((micros * baseRate() + perTick - 1) / perTick);
 }
 
 unsigned Timer::ticksForHz(double Hz) const {
@@ -20,6 +20,7 @@
 #include "minimath.h"
 
 #include "gpio.h" //for control of associated pins
+#include "durations.h"
 
 //construction aid
 struct TimerConstant {
@@ -151,6 +152,13 @@ struct Timer : public APBdevice {
   unsigned ticksForSeconds(double secs) const;
   unsigned ticksForHz(double Hz) const;
   float secondsInTicks(unsigned ticks) const;
+  /** integer only, rounds up like ticksForSeconds */
+  unsigned ticksForLongMicros(u64 micros) const;
+
+  /** ticks at the present prescale for any Time::Duration */
+  template<typename R, u64 N, u64 D> unsigned ticksFor(Time::Duration<R, N, D> span) const {
+    return ticksForLongMicros(Time::durationCast<Time::LongMicros>(span).count);
+  }
   enum ExternalInputOption {
     Xor, CH1, CH2
   };
@@ -5,7 +5,7 @@
 #ifdef ARDUINO
 
 extern TimeValue millis();
-void readit(TimeValue &ts){
+void readit(TimeValue &ts, bool /*realtime*/){
   ts=millis();
 }
 
@@ -13,13 +13,42 @@ double StopWatch::asSeconds(const TimeValue ts){
   return (ts)*1000;//arduino hardcoded to millisecond.
 }
 
+TimeValue StopWatchCore::ticksForMicros(u64 micros) {
+  return micros / 1000;
+}
+
 #elif defined(__linux__)
-void readit(TimeValue &){
-//  ts=snapLongTime();
+#include <time.h>
+
+/** nanoseconds, of the wall clock (never set backwards) or of this thread's cpu time */
+void readit(TimeValue &ts, bool realtime) {
+  timespec now;
+  clock_gettime(realtime ? CLOCK_MONOTONIC : CLOCK_THREAD_CPUTIME_ID, &now);
+  ts = TimeValue(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+double StopWatch::asSeconds(const TimeValue ts) {
+  return double(ts) * 1e-9;
+}
+
+TimeValue StopWatchCore::ticksForMicros(u64 micros) {
+  return micros * 1000;
+}
+
+#elif STOPWATCH_CYCLES  //project wide option for cycle accurate stopwatches, M3 and up.
+
+#include "cycleclock.h"
+
+void readit(TimeValue &ts, bool /*realtime*/) {
+  ts = CycleClock::now();
 }
 
-double StopWatch::asSeconds(const TimeValue ){
-//  return secondsForLongTime(ts);
+double StopWatch::asSeconds(const TimeValue ts) {
+  return CycleClock::secondsFor(ts);
+}
+
+TimeValue StopWatchCore::ticksForMicros(u64 micros) {
+  return CycleClock::cyclesForMicros(CycleClock::rate(), micros);
 }
 
 #else
@@ -28,7 +57,7 @@ double StopWatch::asSeconds(const TimeValue ){
 
 using namespace SystemTimer;
 
-void readit(TimeValue &ts) {
+void readit(TimeValue &ts, bool /*realtime*/) {
   ts = snapLongTime();
 }
 
@@ -36,28 +65,32 @@ double StopWatch::asSeconds(const TimeValue ts) {
   return secondsForLongTime(ts);
 }
 
+TimeValue StopWatchCore::ticksForMicros(u64 micros) {
+  return (micros / 1000000) * ticksPerSecond() + SystemTimer::ticksForMicros(int(micros % 1000000));
+}
+
 #endif
 
-StopWatchCore::StopWatchCore(bool beRunning, bool /*realElseProcess*/) {
-  readit(started);
+StopWatchCore::StopWatchCore(bool beRunning, bool realElseProcess) : realtime(realElseProcess) {
+  readit(started, realtime);
   stopped = started;
   running = beRunning;
 }
 
 void StopWatchCore::start() {
-  readit(started);
+  readit(started, realtime);
   running = true;
 }
 
 void StopWatchCore::stop() {
   if (flagged(running)) {
-    readit(stopped);
+    readit(stopped, realtime);
   }
 }
 
 TimeValue StopWatchCore::peek(bool andRoll) {
   if (running) {
-    readit(stopped);
+    readit(stopped, realtime);
   }
   TimeValue elapsed = stopped - started;
 
@@ -74,7 +107,7 @@ bool StopWatchCore::isRunning() const {
 /////////////////////
 double StopWatch::absolute() {
   if (running) {
-    readit(stopped);
+    readit(stopped, realtime);
   }
   return asSeconds(stopped);
 }
@@ -119,8 +152,20 @@ unsigned StopWatch::wraps(TimeValue ticks, bool andRoll) {
   return delta / ticks;//strictly truncate, do not round.
 }
 
+unsigned StopWatch::periods(TimeValue period, bool andRoll) {
+  TimeValue delta = peek(false);
+  if (period == 0 || delta < period) {
+    return 0;
+  }
+  TimeValue count = delta / period;
+  if (andRoll && running) {
+    started += count * period;//not 'stopped', keep the fraction of a period
+  }
+  return unsigned(count);
+}
+
 bool Timeout::check(bool andRestart) {
-  if (wraps(interval, false) > 0) {
+  if (peek(false) >= interval) {//a compare rather than the divide in wraps()
     if (andRestart) {
       start();
     } else {
@@ -133,5 +178,9 @@ bool Timeout::check(bool andRestart) {
 }
 
 double Timeout::dueIn() {
-  return asSeconds(isRunning() ? (interval - peek()) : 0);
+  return double(dueInTicks()) * asSeconds(1);
+}
+
+s64 Timeout::dueInTicks() {
+  return isRunning() ? s64(interval - peek()) : 0;
 }
@@ -2,6 +2,7 @@
 #define STOPWATCH_H
 
 #include "eztypes.h"
+#include "durations.h"
 
 typedef u64 TimeValue;
 
@@ -12,6 +13,8 @@ protected:
   TimeValue started;
   TimeValue stopped;
   bool running;
+  /** only the host build has a choice of clocks, see constructor */
+  bool realtime;
 public:
   /** @param beRunning is whether to start timer upon construction.
       @param realElseProcess is whether to track realtime or thread-active-time */
@@ -22,8 +25,20 @@ public:
   void stop();
   /** read elapsed time as ticks, for when you can't afford the do math in elapsed(), @param andRoll restarts timer when true */
   TimeValue peek(bool andRoll = false);
+
+  /** @returns ticks between start and stop, or now if running. Integer only, ISR safe. */
+  TimeValue elapsedTicks() {
+    return peek(false);
+  }
   /** convenient for passing around 'timeout pending' state */
   bool isRunning() const;
+
+  /** @returns ticks of this class's clock in @param micros, integer only */
+  static TimeValue ticksForMicros(u64 micros);
+
+  template<typename R, u64 N, u64 D> static TimeValue ticksFor(Time::Duration<R, N, D> span) {
+    return ticksForMicros(Time::durationCast<Time::LongMicros>(span).count);
+  }
 };
 
 class StopWatch : public StopWatchCore {
@@ -43,13 +58,35 @@ public:
 
   /** @returns the number of cycles of @param ticks that have @see elapsed() */
   unsigned wraps(TimeValue ticks, bool andRoll = true);
+
+  /** @returns the number of whole @param period's that have elapsed, integer only.
+   * Rolling only moves the start by whole periods, so unlike cycles() the fraction carries over and there is no cumulative drift.
+   * The usual answer is 0, which costs a compare, the divide is only done when there is something to count.
+   * Not an overload of cycles(), an integer would have been ambiguous between the two. */
+  unsigned periods(TimeValue period, bool andRoll = true);
+
+  template<typename R, u64 N, u64 D> unsigned periods(Time::Duration<R, N, D> period, bool andRoll = true) {
+    return periods(ticksFor(period), andRoll);
+  }
 };
 
+/** on the host pass realElseProcess=true, else the time only passes while this thread is running.
+ * interval is in StopWatch ticks, so arming and checking are integer compares. */
 class Timeout : public StopWatch {
 public:
-  TimeValue interval;
+  TimeValue interval = 0;
   using StopWatch::StopWatch;
 
+  /** set the interval and start timing */
+  void arm(TimeValue ticks) {
+    interval = ticks;
+    start();
+  }
+
+  template<typename R, u64 N, u64 D> void arm(Time::Duration<R, N, D> span) {
+    arm(ticksFor(span));
+  }
+
   /** @returns whether timeout has expired, and if so either restarts it or stops it */
   bool check(bool andRestart);
 
@@ -78,6 +115,9 @@ public:
 
   /** @returns how long until this guy timesout, negative if overdue which it will be if you don't check it often enough. */
   double dueIn();
+
+  /** dueIn() in ticks, 0 if not running */
+  s64 dueInTicks();
 };
 
 #endif // STOPWATCH_H
@@ -7,27 +7,169 @@
 #include "minimath.h"  //safe division functions
 
 #include "tableofpointers.h"  //*RefTable
+#include "systickread.h"
 
 MakeRefTable(SystemTicker);
 
 namespace SystemTimer {
 //when the following were simple static's Rowley would not show them.
-  static SysTicks milliTime(0); //storage for global tick time.
-  static unsigned macroTime(0); //extended range tick time
+//volatile as the snap functions spin on them changing out from under them.
+  static volatile SysTicks milliTime(0); //storage for global tick time.
+  static volatile unsigned macroTime(0); //extended range tick time
+  /** counter clocks per tick, what startPeriodicTimer computed */
+  static unsigned countsPerTick(0);
+  /** for the integer conversions, also computed by startPeriodicTimer */
+  static Hertz tickRate(0);
+  static Reciprocal ticksPerMilli;
+  static Reciprocal ticksPerMicro;
+  static Reciprocal millisPerTick;
+  static Reciprocal microsPerTick;
 }
 using namespace SystemTimer;
 
-HandleFault(15) { //15: system tick
-  ++milliTime;
-  if (milliTime == 0) {
+/** add @param elapsed ticks to the long time */
+static void tockTicks(SysTicks elapsed) {
+  SysTicks before = milliTime;
+  milliTime = before + elapsed;
+  if (milliTime < before) {
     //we have rolled over and anything waiting on a particular value will have failed
     ++macroTime;//but rollover of this is not going to happen for decades.
   }
+}
+
+MakeRefTable(DeadlineTicker);
+
+MakeRefTable(DividedTicker);
+
+static unsigned divisorOf(const DividedTicker &dt) {
+  return dt.divisor ? dt.divisor : 1;
+}
+
+/** call the DividedTickers that are due within the last @param elapsed ticks, each at most once.
+ * @returns ticks until the soonest is next due */
+static SysTicks runDividedTickers(SysTicks elapsed) {
+  SysTicks soonest = ~0u;
+  ForRefs(DividedTicker) {
+    DividedTicker &dt = **it;
+    if (dt.countdown <= elapsed) {
+      (*dt.tick)();
+      unsigned divisor = divisorOf(dt);
+      dt.countdown = divisor - (elapsed - dt.countdown) % divisor; //stay in phase even if we slept past some
+    } else {
+      dt.countdown -= elapsed;
+    }
+    if (dt.countdown < soonest) {
+      soonest = dt.countdown;
+    }
+  }
+  return soonest;
+}
+
+/** what spreadDividedTickers came up with */
+static unsigned worstLoad = 0;
+
+/** the phase pattern repeats over the lcm of the divisors, if that gets silly we only look at this many ticks of it.
+ * 5040 is divisible by 1 through 10 and by most rates anyone asks for. */
+constexpr unsigned MaxSpan = 5040;
+
+/** @returns number of DividedTickers with a phase already assigned that would run on tick @param t of the pattern */
+static unsigned dividedLoadAt(unsigned t) {
+  unsigned load = 0;
+  ForRefs(DividedTicker) {
+    const DividedTicker &dt = **it;
+    if (dt.phase != DividedTicker::AnyPhase && t % divisorOf(dt) == dt.phase) {
+      ++load;
+    }
+  }
+  return load;
+}
+
+/** assign phases to the DividedTickers that don't care, such that the most that run on any one tick is as few as we can manage.
+ * Greedy, most frequent first, each takes the phase whose busiest tick is least busy so far. Ties go to the lowest phase, so the result doesn't vary from boot to boot.
+ * Only run at init, it is O(span*n*n) which for a dozen tickers on a 1kHz tick is a few milliseconds. */
+static void spreadDividedTickers() {
+  unsigned span = 1;
+  ForRefs(DividedTicker) {
+    DividedTicker &dt = **it;
+    unsigned divisor = divisorOf(dt);
+    dt.phase = dt.requested == DividedTicker::AnyPhase ? DividedTicker::AnyPhase : dt.requested % divisor;
+    unsigned a = span;
+    unsigned b = divisor;
+    while (b) {
+      unsigned r = a % b;
+      a = b;
+      b = r;
+    }
+    u64 lcm = u64(span / a) * divisor;
+    span = lcm > MaxSpan ? MaxSpan : unsigned(lcm);
+  }
+
+  while (true) {
+    DividedTicker *next = nullptr;
+    ForRefs(DividedTicker) {
+      DividedTicker &dt = **it;
+      if (dt.phase == DividedTicker::AnyPhase && (!next || divisorOf(dt) < divisorOf(*next))) {
+        next = &dt;
+      }
+    }
+    if (!next) {
+      break;
+    }
+    unsigned divisor = divisorOf(*next);
+    unsigned best = 0;
+    unsigned bestWorst = ~0u;
+    for (unsigned phase = 0; phase < divisor; ++phase) {
+      unsigned worst = 0;
+      for (unsigned t = phase; t < span; t += divisor) {
+        unsigned load = dividedLoadAt(t);
+        if (load > worst) {
+          worst = load;
+        }
+      }
+      if (worst < bestWorst) {
+        bestWorst = worst;
+        best = phase;
+      }
+    }
+    next->phase = best;
+  }
+
+  //everyone else runs on every tick
+  unsigned everyTick = 0;
   ForRefs(SystemTicker) {
-    (**it)();
+    ++everyTick;
+  }
+  ForRefs(DeadlineTicker) {
+    ++everyTick;
+  }
+  unsigned worst = 0;
+  for (unsigned t = 0; t < span; ++t) {
+    unsigned load = dividedLoadAt(t);
+    if (load > worst) {
+      worst = load;
+    }
+  }
+  worstLoad = everyTick + worst;
+
+  ForRefs(DividedTicker) {
+    DividedTicker &dt = **it;
+    dt.countdown = dt.phase + 1; //the first tick after starting is tick 0 of the pattern
   }
 }
 
+#if SYSTICK_TICKLESS
+using SysTickRead::Period;
+
+/** the isr and wakeWithin() build the next period in the slot not in use then increment 'current', the low bit of which picks the slot. */
+static Period periods[2];
+static volatile unsigned current = 0;
+/** tick count when DeadlineTickers were last called */
+static SysTicks lastDeadlineCall = 0;
+/** the soonest wakeWithin() asked for while the isr was due or running, which the isr applies when it starts the next period. 0 for none. */
+static SysTicks wakeRequest = 0;
+
+#endif
+
 struct SysTicker {
   volatile unsigned enableCounting: 1; //enable counting
   unsigned enableInterrupt: 1; //enable interrupt
@@ -37,9 +179,9 @@ struct SysTicker {
   volatile unsigned rolledOver: 1; //indicates rollover, clears on read
   unsigned  : 32 - 17;
 
-  unsigned reload; //(only 24 bits are implemented) cycle = this+1.
+  volatile unsigned reload; //(only 24 bits are implemented) cycle = this+1.
 
-  unsigned value; //
+  volatile unsigned value; //down counter, any write clears it which makes it reload on its next clock
   //following is info chip provides to user, some manufacturers are off by a power of 10 here.
   unsigned tenms: 24; //value to get 100Hz
   unsigned  : 30 - 24;
@@ -50,6 +192,7 @@ struct SysTicker {
     enableInterrupt = 0;
     enableCounting = 0;
     reload = reloader - 1; //for more precise periodicity
+    value = 0; //any write clears it, so the first tick is a whole one.
     bool hack = rolledOver; //reading clears it
     enableCounting = 1;
     enableInterrupt = 1;
@@ -58,7 +201,7 @@ struct SysTicker {
   } /* start */
 
   SysTicks ticksPerSecond() const {
-    unsigned effectiveDivider = reload + 1;
+    unsigned effectiveDivider = countsPerTick;
 
     if (!fullspeed) {
       effectiveDivider *= 8;
@@ -66,20 +209,269 @@ struct SysTicker {
     return rate(clockRate(CPU), effectiveDivider);
   }
 
-  SysTicks ticksForMicros(unsigned us) const {
-    return (us * ticksPerSecond()) / 1000000;
+  SysTicks ticksForHertz(float hz) const {
+    return ratio(ticksPerSecond(), hz);
   }
 
-  SysTicks ticksForMillis(unsigned ms) const {
-    return (ms * ticksPerSecond()) / 1000;
+  /** @returns rate of the down counter itself */
+  Hertz countsPerSecond() const {
+    return fullspeed ? clockRate(CPU) : rate(clockRate(CPU), 8);
   }
+};
 
-  SysTicks ticksForHertz(float hz) const {
-    return ratio(ticksPerSecond(), hz);
+soliton(SysTicker, 0xE000E010);
+
+/** ICSR.PENDSTSET: the counter has hit zero but the tick isr hasn't run yet, as happens when we are called from a higher priority isr or with interrupts masked. */
+const SFRbit<SCB(0x04), 26> tickPending;
+
+#if defined(__CORTEX_M) && __CORTEX_M < 3
+/** M0's only show SHCSR to a debugger. All we can tell is whether we are the tick isr, which tickless readers need as they can't otherwise tell that the isr has yet to begin the next period.
+ * The periodic isr counts its tick first instead, so that its tickers don't need this. Either way a reader more urgent than the tick can be a period behind, see systickread.h */
+static const struct {
+  operator bool() const {
+    return SYSTICK_TICKLESS && (IPSR & 0x3F) == 15;
+  }
+} tickActive;
+
+/** count first, the window in which a more urgent reader is a period behind is then only the isr's first few instructions */
+constexpr bool countLast = false;
+
+/** there is no FAULTMASK, we have to restore PRIMASK before the exception return */
+using FinalMask = InterruptMask;
+#else
+/** SHCSR.SYSTICKACT: the tick isr has been entered and has not yet returned, we are it or we have preempted it */
+const SFRbit<SCB(0x24), 11> tickActive;
+
+/** count last, so that the readers' count of uncounted reloads is right however far the isr has got */
+constexpr bool countLast = true;
+
+/** the tick isr's closing act goes under one of these: it masks everything and the isr's exception return clears FAULTMASK,
+ * so nothing else runs between that act and SYSTICKACT going away. See systickread.h */
+struct FinalMask {
+  FinalMask() {
+    __asm volatile("cpsid f" ::: "memory");
   }
 };
+#endif
 
-soliton(SysTicker, 0xE000E010);
+/** what SysTickRead needs, directly on the registers and the statics above */
+struct TickHardware {
+  SysTicks millis() const {
+    return milliTime;
+  }
+
+  unsigned macros() const {
+    return macroTime;
+  }
+
+  unsigned counter() const {
+    return theSysTicker.value;
+  }
+
+  bool pending() const {
+    return tickPending;
+  }
+
+  bool active() const {
+    return tickActive;
+  }
+
+#if SYSTICK_TICKLESS
+  unsigned generation() const {
+    unsigned snap = current;
+    __asm volatile("" ::: "memory");
+    return snap;
+  }
+
+  const Period &period(unsigned generation) const {
+    return periods[generation & 1];
+  }
+#endif
+};
+
+#if SYSTICK_PROFILE
+#if __CORTEX_M >= 3
+#include "cycleclock.h"
+
+static u32 profileMark() {
+  return CycleClock::snap();
+}
+
+static u32 profileSince(u32 mark, u32 now) {
+  return now - mark;
+}
+
+#else
+/** M0's have no cycle counter, we use the systick itself. It is a down counter that only reloads during the isr if the isr runs for a whole period, which is an overrun by anyone's budget. */
+static u32 profileMark() {
+  return theSysTicker.value;
+}
+
+static u32 profileSince(u32 mark, u32 now) {
+  return now <= mark ? mark - now : mark + theSysTicker.reload + 1 - now;
+}
+#endif
+
+namespace SystemTimer {
+  static TickerProfile tickerStats[SYSTICK_PROFILE_SLOTS];
+  static TickerProfile wholeTick;
+  static u32 tickBudget = 0;
+  static volatile unsigned overruns = 0;
+  static Overrun latestOverrun;
+  /** slot of the slowest SystemTicker of the present tick */
+  static unsigned culprit = ~0u;
+}
+
+/** what tick number @param tick took, and whether that was too long */
+static void noteTick(u32 began, SysTicks tick) {
+  u32 took = profileSince(began, profileMark());
+  wholeTick.note(took);
+  if (tickBudget && took > tickBudget) {
+    latestOverrun = {tick, took, culprit};
+    overruns = overruns + 1;
+  }
+}
+
+static void callSystemTickers() {
+  unsigned slot = 0;
+  u32 slowest = 0;
+  culprit = ~0u;
+  ForRefs(SystemTicker) {
+    u32 before = profileMark();
+    (**it)();
+    u32 took = profileSince(before, profileMark());
+    if (slot < SYSTICK_PROFILE_SLOTS) {
+      TickerProfile &stats = tickerStats[slot];
+      stats.ticker = **it;
+      stats.note(took);
+      if (took > slowest) {
+        slowest = took;
+        culprit = slot;
+      }
+    }
+    ++slot;
+  }
+}
+
+#else
+static u32 profileMark() {
+  return 0;
+}
+
+static void noteTick(u32, SysTicks) {}
+
+static void callSystemTickers() {
+  ForRefs(SystemTicker) {
+    (**it)();
+  }
+}
+#endif
+
+#if SYSTICK_TICKLESS
+/** largest period the 24 bit counter can do, or 1 if there are SystemTickers */
+static SysTicks maxSleep = 1;
+
+/** SystemTickers are written for a call at each tick, not a burst of them after a sleep */
+static bool haveSystemTickers() {
+  ForRefs(SystemTicker) {
+    return true;
+  }
+  return false;
+}
+
+/** after a period ends the counter runs the longest segment it can, so that however late or long the isr is the counter has reloaded only once when it restarts it */
+constexpr unsigned Runway = 1u << 24;
+/** the shortest first segment, long enough that the counter is still in it when we have set the runway reload. Counts may be cpu clocks. */
+constexpr unsigned MinSegment = 32;
+
+/** replace the period we are in with one of @param ticks ticks that began at tick @param start, @param countingFrom minus the counter is how far we are into the present segment.
+ * Interrupts must be masked by the caller, the gap between reading the counter and restarting it is a few clocks and is the only drift this mode adds. */
+static void restart(SysTime start, SysTicks ticks, unsigned countingFrom) {
+  Period &next = periods[(current + 1) & 1];
+  unsigned consumed = countingFrom - theSysTicker.value;
+  unsigned target = ticks * countsPerTick;
+  while (consumed + MinSegment > target) {
+    //too close or already past, which only happens if latency was horrible. Whole ticks so that the end stays where the readers compute it.
+    ++ticks;
+    target += countsPerTick;
+  }
+  unsigned remaining = target - consumed;
+  next.start = start;
+  next.ticks = ticks;
+  theSysTicker.reload = remaining - 1;
+  theSysTicker.value = 0;
+  while (theSysTicker.value == 0) {
+    //wait for the reload, which happens on the counter's clock which may be 1/8 of ours.
+  }
+  theSysTicker.reload = Runway - 1;//only the reload at the end of the period sees this
+  next.loaded = Runway;
+  __asm volatile("" ::: "memory");
+  current = current + 1;
+}
+
+HandleFault(15) { //15: system tick, which is now the end of a period
+  u32 began = profileMark();
+  const Period &was = periods[current & 1];
+  tockTicks(was.ticks);
+  SysTicks elapsed = milliTime - lastDeadlineCall;
+  lastDeadlineCall = milliTime;
+  for (SysTicks tick = elapsed; tick-- > 0;) {
+    callSystemTickers();//maxSleep keeps this to one call unless the isr was so late that restart() lengthened the period.
+  }
+  SysTicks soonest = runDividedTickers(elapsed);
+  if (soonest > maxSleep) {
+    soonest = maxSleep;
+  }
+  ForRefs(DeadlineTicker) {
+    SysTicks due = (**it)(elapsed);
+    if (due && due < soonest) {
+      soonest = due;
+    }
+  }
+  noteTick(began, milliTime);//before the restart, which trashes the M0 profile clock
+  FinalMask untilReturn;
+  if (wakeRequest) {//masked, so no more can come in until the new period is in place
+    if (wakeRequest < soonest) {
+      soonest = wakeRequest;
+    }
+    wakeRequest = 0;
+  }
+  //we are a little way into a segment of 'loaded' counts that began when the period ended.
+  restart(was.start + was.ticks, soonest, was.loaded);
+}
+
+static SysTime snapCounts() {
+  TickHardware hw;
+  return SysTickRead::ticklessCounts(hw, countsPerTick);
+}
+
+#else
+
+HandleFault(15) { //15: system tick
+  u32 began = profileMark();
+  if (!countLast) {
+    tockTicks(1);
+  }
+  callSystemTickers();
+  runDividedTickers(1);
+  ForRefs(DeadlineTicker) {//what they want doesn't matter, they get called every tick.
+    (**it)(1);
+  }
+  if (countLast) {
+    noteTick(began, milliTime + 1);
+    FinalMask untilReturn;
+    tockTicks(1);
+  } else {
+    noteTick(began, milliTime);
+  }
+}
+
+/** tick count and counter read as a consistent pair without stopping the counter */
+static SysTime snapCounts() {
+  TickHardware hw;
+  return SysTickRead::counts(hw, countsPerTick);
+}
+#endif
 
 namespace SystemTimer {
 
@@ -97,9 +489,52 @@ namespace SystemTimer {
       theSysTicker.fullspeed ? clockRate(CPU) :  //STM addition
       #endif
       clockRate(AHB1) / 8;//standard defined by ARM
-    theSysTicker.start(rate(num, persecond));
+    countsPerTick = rate(num, persecond);
+    tickRate = theSysTicker.ticksPerSecond();
+    ticksPerMilli = {tickRate, 1000};
+    ticksPerMicro = {tickRate, 1000000};
+    millisPerTick = {1000, tickRate};
+    microsPerTick = {1000000, tickRate};
+#if SYSTICK_TICKLESS
+    maxSleep = bitMask(24) / countsPerTick;//reload is 24 bits, period is reload+1
+    if (maxSleep == 0 || haveSystemTickers()) {
+      maxSleep = 1;
+    }
+    periods[current & 1] = {milliTime | (SysTime(macroTime) << 32), 1, countsPerTick};
+    lastDeadlineCall = milliTime;
+#endif
+    spreadDividedTickers();
+#if SYSTICK_PROFILE && __CORTEX_M >= 3
+    CycleClock::start();
+#endif
+    theSysTicker.start(countsPerTick);
   }
 
+#if SYSTICK_TICKLESS
+  void wakeWithin(SysTicks ticks) {
+    if (ticks == 0) {
+      ticks = 1;
+    } else if (ticks > maxSleep) {
+      return;//can't sleep longer than this anyway
+    }
+    InterruptMask masked;
+    const Period &p = periods[current & 1];
+    unsigned fullCount = p.ticks * countsPerTick;
+    unsigned snaptick = theSysTicker.value;
+    if (tickPending || tickActive || snaptick > fullCount) {
+      //the period is over (on the runway) and the isr has yet to start the next one, we may be it or have preempted it. It applies this when it does.
+      if (!wakeRequest || ticks < wakeRequest) {
+        wakeRequest = ticks;
+      }
+      return;
+    }
+    if (snaptick > ticks * countsPerTick) {
+      SysTicks done = (fullCount - snaptick) / countsPerTick;
+      restart(p.start, done + ticks, fullCount);
+    }
+  }
+#endif
+
   double secondsForTicks(SysTicks ticks) {
     return ratio(double(ticks), double(theSysTicker.ticksPerSecond()));
   }
@@ -112,21 +547,37 @@ namespace SystemTimer {
     if (sec <= 0) {
       return 0;
     }
-    return theSysTicker.ticksForMicros(unsigned(sec * 1000000));
+    return ticksPerMicro.of(unsigned(sec * 1000000));
   }
 
   SysTicks ticksForMillis(int ms) {
     if (ms <= 0) {
       return 0;
     }
-    return theSysTicker.ticksForMillis(ms);
+    return ticksPerMilli.of(ms);
   }
 
   SysTicks ticksForMicros(int us) {
     if (us <= 0) {
       return 0;
     }
-    return theSysTicker.ticksForMicros(us);
+    return ticksPerMicro.of(us);
+  }
+
+  SysTicks ticksForRate(Hertz hz) {
+    return hz ? tickRate / hz : 0;
+  }
+
+  Hertz ticksPerSecond() {
+    return tickRate;
+  }
+
+  u32 millisForTicks(SysTicks ticks) {
+    return millisPerTick.of(ticks);
+  }
+
+  u64 microsForTicks(SysTicks ticks) {
+    return microsPerTick.wide(ticks);
   }
 
   SysTicks ticksForHertz(float hz) {
@@ -139,29 +590,170 @@ namespace SystemTimer {
   }
 
   SysTicks snapTickTime() {
-    //#some of the superficially gratuitous stuff in here exists to minimize the clocks spent with counting disabled.
-    SysTicks snapms;
-    SysTicks snaptick;
-    theSysTicker.enableCounting = 0; //can't use bitlock on a field in a struct :(
-    snapms = milliTime;
-    snaptick = theSysTicker.value;
-    theSysTicker.enableCounting = 1;
-    //add some to systick to compensate for the dead time of this routine.
-    snaptick -= 6;//counted clocks between the disable and enable operations
-    //todo: might have skipped a tick, and failed to execute the isr which could cause some usages to have an unexpected delay or extension.
-    return ((snapms + 1) * (theSysTicker.reload + 1)) - snaptick;
-  }
-
-  SysTime snapLongTime() {//this presumes little endian 64 bit integer.
-    theSysTicker.enableCounting = 0; //can't use bitlock on a field in a struct :(
-    SysTime retval = milliTime | (SysTime(macroTime) << 32);//need a hack to get compiler to be efficient here.
-    theSysTicker.enableCounting = 1; //todo:3 add some to systick to compensate for the dead time of this routine.
-    return retval;
+    return SysTicks(snapCounts());
+  }
+
+  SysTime snapFineTime() {
+    return snapCounts();
+  }
+
+  double secondsForFineTime(SysTime counts) {
+    return ratio(double(counts), double(theSysTicker.countsPerSecond()));
+  }
+
+  SysTime snapLongTime() {
+#if SYSTICK_TICKLESS
+    //milliTime is only updated at the end of a period
+    TickHardware hw;
+    return SysTickRead::ticklessTicks(hw, countsPerTick);
+#else
+    TickHardware hw;
+    return SysTickRead::ticks(hw);
+#endif
   }
 
   unsigned tocks() {
-    return milliTime;
+    return unsigned(snapLongTime());
+  }
+
+  unsigned worstTickLoad() {
+    return worstLoad;
+  }
+
+#if SYSTICK_PROFILE
+  /** the isr might be updating what we copy, so we copy again until the call count doesn't change under us */
+  static TickerProfile snapProfile(const TickerProfile &live) {
+    TickerProfile copy;
+    do {
+      copy = live;
+      __asm volatile("" ::: "memory");
+    } while (copy.calls != *static_cast<const volatile u32 *>(&live.calls));
+    return copy;
+  }
+
+  bool tickerProfile(unsigned index, TickerProfile &copy) {
+    unsigned count = 0;
+    ForRefs(SystemTicker) {
+      ++count;
+    }
+    if (index >= count || index >= SYSTICK_PROFILE_SLOTS) {
+      return false;
+    }
+    copy = snapProfile(tickerStats[index]);
+    return true;
+  }
+
+  TickerProfile tickProfile() {
+    return snapProfile(wholeTick);
+  }
+
+  Hertz profileRate() {
+#if __CORTEX_M >= 3
+    return CycleClock::rate();
+#else
+    return theSysTicker.countsPerSecond();
+#endif
+  }
+
+  void setTickBudget(u32 units) {
+    tickBudget = units;
+  }
+
+  unsigned tickOverruns(Overrun &latest) {
+    unsigned count;
+    do {
+      count = overruns;
+      latest = latestOverrun;
+    } while (count != overruns);
+    return count;
+  }
+
+  void resetProfile() {
+    InterruptMask masked;//restores rather than enables, so this can be called from an isr or with interrupts off
+    for (TickerProfile &stats : tickerStats) {
+      stats = {};
+    }
+    wholeTick = {};
+    overruns = 0;
+    latestOverrun = {0, 0, ~0u};
+  }
+
+  /** right justified decimal in a field of @param width, @returns where the next column goes */
+  static char *column(char *cursor, u64 value, unsigned width) {
+    char digits[20];
+    unsigned count = 0;
+    do {
+      digits[count++] = char('0' + value % 10);
+      value /= 10;
+    } while (value && count < sizeof(digits));
+    while (width-- > count) {
+      *cursor++ = ' ';
+    }
+    while (count) {
+      *cursor++ = digits[--count];
+    }
+    return cursor;
+  }
+
+  static char *text(char *cursor, const char *words) {
+    while (*words) {
+      *cursor++ = *words++;
+    }
+    return cursor;
+  }
+
+  static char *hexColumn(char *cursor, uintptr_t value) {
+    cursor = text(cursor, " 0x");
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      *cursor++ = "0123456789ABCDEF"[(value >> shift) & 15];
+    }
+    return cursor;
+  }
+
+  static void row(ProfileLine out, char *line, const TickerProfile &stats) {
+    char *cursor = column(line + 14, stats.calls, 11);
+    cursor = column(cursor, stats.min, 9);
+    cursor = column(cursor, stats.max, 9);
+    cursor = column(cursor, stats.average(), 9);
+    *cursor = 0;
+    out(line);
+  }
+
+  void dumpProfile(ProfileLine out) {
+    char line[80];
+    char *cursor = text(line, "units per second");
+    cursor = column(cursor, profileRate(), 11);
+    *cursor = 0;
+    out(line);
+    out("slot    ticker      calls      min      max      avg");
+    TickerProfile stats;
+    for (unsigned index = 0; tickerProfile(index, stats); ++index) {
+      cursor = column(line, index, 3);
+      hexColumn(cursor, uintptr_t(stats.ticker));
+      row(out, line, stats);
+    }
+    text(line, "  whole tick  ");
+    row(out, line, tickProfile());
+    Overrun latest;
+    unsigned count = tickOverruns(latest);
+    cursor = text(line, "budget");
+    cursor = column(cursor, tickBudget, 9);
+    cursor = text(cursor, " overruns");
+    cursor = column(cursor, count, 6);
+    if (count) {
+      cursor = text(cursor, " latest at");
+      cursor = column(cursor, latest.when, 11);
+      cursor = text(cursor, " took");
+      cursor = column(cursor, latest.took, 9);
+      if (latest.culprit != ~0u) {
+        cursor = text(cursor, " slot");
+        cursor = column(cursor, latest.culprit, 3);
+      }
+    }
+    *cursor = 0;
+    out(line);
   }
+#endif
 
   void setPriority(unsigned int TickPriority) {
     setInterruptPriorityFor(-15, TickPriority);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "eztypes.h"
+#include "durations.h"
 
 /**
 system timer service (a not so fast timer)
@@ -23,7 +24,150 @@ using SysTime = uint64_t;
 //functions to call on the SystemTick
 using SystemTicker = void (*)();
 
+/** set SYSTICK_TICKLESS to 1 project wide to have the system tick interrupt only when some DeadlineTicker needs it, instead of every tick.
+ * SystemTickers are still called every tick, so while any are registered the tick never sleeps for more than one. Convert them to DeadlineTickers to get the savings.
+ * Time keeping stays as accurate as in periodic mode, the snap functions interpolate from the counter.
+ */
+#ifndef SYSTICK_TICKLESS
+#define SYSTICK_TICKLESS 0
+#endif
+
+/** set SYSTICK_PROFILE to 1 project wide to have the tick isr time each SystemTicker, see SystemTimer::tickerProfile().
+ * Units are cpu cycles from the DWT on M3 and up (it calls CycleClock::start() for you), counter clocks of the systick itself on M0's.
+ * The cost is a counter read and a few adds per ticker per tick.
+ */
+#ifndef SYSTICK_PROFILE
+#define SYSTICK_PROFILE 0
+#endif
+
+/** how many SystemTickers get their own statistics, any past that are only counted in the whole tick's. */
+#ifndef SYSTICK_PROFILE_SLOTS
+#define SYSTICK_PROFILE_SLOTS 16
+#endif
+
+/** MakeRef(DeadlineTicker, YourRoutine);
+ * called from the systick isr with the number of ticks since it was last called, @returns the number of ticks until it next needs to be called, 0 for 'don't care'.
+ * In periodic mode these are called every tick with elapsed=1 and what they return is ignored.
+ */
+using DeadlineTicker = SysTicks (*)(SysTicks elapsed);
+
+/** a SystemTicker that only needs calling every 'divisor' ticks, such as a 10Hz debouncer on a 1kHz tick.
+ * MakeDividedTicker(YourTickRoutine, 100, DividedTicker::AnyPhase);
+ * Those with AnyPhase get spread out by startPeriodicTimer so that they don't all run on the same tick, see SystemTimer::worstTickLoad().
+ * In tickless mode they are called when due, they don't need to be converted to DeadlineTickers.
+ */
+struct DividedTicker {
+  enum : unsigned {
+    AnyPhase = ~0u
+  };
+
+  SystemTicker tick;
+  /** call every this many ticks, 0 is treated as 1 */
+  unsigned divisor;
+  /** which of the 'divisor' ticks to run on, AnyPhase to let the table builder pick */
+  unsigned requested;
+  /** what was picked, or requested modulo divisor */
+  unsigned phase;
+  /** ticks until the next call, maintained by the tick isr */
+  unsigned countdown;
+};
+
+/** the tick rate that startPeriodicTimer is given, if it is a constant. Set project wide to make SystemTimer::ticks<>() available. 0 for 'not known until runtime'. */
+#ifndef SYSTICK_HZ
+#define SYSTICK_HZ 0
+#endif
+
+#define MakeDividedTicker(fn, divisor, phase) DividedTicker fn##Divided {fn, divisor, phase, 0, 0}; MakeRef(DividedTicker, fn##Divided)
+
 namespace SystemTimer {
+  /** an amount of time for ticks<>(), N/PerSecond seconds. Use the aliases below. */
+  template<u32 N, u32 PerSecond> struct TimeSpan {
+    /** truncates, like the runtime conversions */
+    static constexpr SysTicks ticksAt(u64 tickHz) {
+      return SysTicks((N * tickHz) / PerSecond);
+    }
+  };
+
+  template<u32 N> using Seconds = TimeSpan<N, 1>;
+  template<u32 N> using Millis = TimeSpan<N, 1000>;
+  template<u32 N> using Micros = TimeSpan<N, 1000000>;
+
+  /** the period of a frequency, for ticks<Hz<50>>() */
+  template<u32 N> struct Hz {
+    static_assert(N > 0, "a frequency of 0 has no period");
+
+    static constexpr SysTicks ticksAt(u64 tickHz) {
+      return SysTicks(tickHz / N);
+    }
+  };
+
+  /** ticks for a compile time amount of time at a compile time tick rate, a constant with no code at all.
+   * const SysTicks debounce = SystemTimer::ticks<Millis<250>>(); */
+  template<typename Span, u32 TickHz = SYSTICK_HZ> constexpr SysTicks ticks() {
+    static_assert(TickHz != 0, "define SYSTICK_HZ project wide, or pass the tick rate as the second template argument");
+    return Span::ticksAt(TickHz);
+  }
+
+  /** @returns milliseconds in @param ticks at a compile time tick rate, truncating */
+  template<u32 TickHz = SYSTICK_HZ> constexpr u64 millisFor(SysTicks ticks) {
+    static_assert(TickHz != 0, "define SYSTICK_HZ project wide, or pass the tick rate as the template argument");
+    return (u64(ticks) * 1000) / TickHz;
+  }
+
+  /** floor(x * numerator/denominator) for a ratio only known at runtime, with multiplies instead of a divide.
+   * The fraction is rounded up so the estimate is never short, then a multiply back takes off the occasional extra one. */
+  struct Reciprocal {
+    u32 numerator;
+    u32 denominator;
+    u32 whole;
+    u32 fraction;
+
+    constexpr Reciprocal(u32 numerator = 0, u32 denominator = 1) :
+      numerator(numerator),
+      denominator(denominator),
+      whole(numerator / denominator),
+      fraction(u32(((u64(numerator % denominator) << 32) + denominator - 1) / denominator)) {}
+
+    constexpr u64 wide(u32 x) const {
+      u64 estimate = u64(x) * whole + ((u64(x) * fraction) >> 32);
+      return estimate * denominator > u64(x) * numerator ? estimate - 1 : estimate;
+    }
+
+    /** wraps if the result doesn't fit */
+    constexpr u32 of(u32 x) const {
+      return u32(wide(x));
+    }
+  };
+
+#if SYSTICK_HZ
+  /** tag for readings of the system tick */
+  struct SysTickClock {};
+
+  using TickSpan = Time::Ticks<SYSTICK_HZ>;
+  /** the tick count of snapLongTime() as a time point, compares correctly across the 32 bit wrap */
+  using TickPoint = Time::TimePoint<SysTickClock, TickSpan>;
+
+  /** ticks for any Time::Duration, a constant when the duration is. */
+  template<typename R, u64 N, u64 D> constexpr SysTicks ticksFor(Time::Duration<R, N, D> span) {
+    return Time::durationCast<TickSpan>(span).count;
+  }
+#else
+  SysTicks ticksForMillis(int ms);
+  SysTicks ticksForMicros(int us);
+  Hertz ticksPerSecond();
+
+  /** ticks for any Time::Duration, integer only. Whole milliseconds go through ticksForMillis, anything finer through microseconds,
+   * whole seconds are taken out first so that no count is truncated to fit an int. */
+  template<typename R, u64 N, u64 D> SysTicks ticksFor(Time::Duration<R, N, D> span) {
+    if (Time::Scale<N, D, 1, 1000>::exact) {
+      u64 millis = Time::durationCast<Time::Duration<u64, 1, 1000>>(span).count;
+      return SysTicks((millis / 1000) * ticksPerSecond()) + ticksForMillis(int(millis % 1000));
+    }
+    u64 micros = Time::durationCast<Time::LongMicros>(span).count;
+    return SysTicks((micros / 1000000) * ticksPerSecond()) + ticksForMicros(int(micros % 1000000));
+  }
+#endif
+
   void disable();
 
   /** sometimes ticks are of middling importance, usually they are about as high as one can get. */
@@ -42,6 +186,14 @@ NB: this is NOT in ticks, it is in probably 8MHz increments, but that may differ
 /** much much longer time range, with a range greater than the life of the instrument., call secondsForLongTime()*/
   SysTime snapLongTime();
 
+/** the long time range of snapLongTime() with the resolution of snapTime(), units are counter clocks, call secondsForFineTime().
+ * None of the snap functions stop the counter, they reread if the tick isr intervenes, so they are monotonic and safe to call from any priority,
+ * except that on M0's a caller more urgent than the tick can be a period behind, see systickread.h and systickmodel.cpp. */
+  SysTime snapFineTime();
+
+  double secondsForFineTime(SysTime counts);
+
+  /** floating point, see millisForTicks() and microsForTicks() for integer versions */
   double secondsForTicks(SysTicks ticks);
 
   double secondsForLongTime(SysTime ticks);
@@ -49,16 +201,101 @@ NB: this is NOT in ticks, it is in probably 8MHz increments, but that may differ
 /** ticks necessary to get a delay of @param sec seconds, 0 if sec is negative */
   SysTicks ticksForSeconds(float sec);
 
-/** ticks, but if ms is negative then you get 0 */
+/** ticks, but if ms is negative then you get 0. Integer only, ISR safe. */
   SysTicks ticksForMillis(int ms);
 
-/** ticks, but is us is negative then you get 0 */
+/** ticks, but is us is negative then you get 0. Integer only, ISR safe. */
   SysTicks ticksForMicros(int us);
 
+/** ticks per cycle of @param hz, integer only, 0 if hz is 0. */
+  SysTicks ticksForRate(Hertz hz);
+
+/** the actual tick rate, which can differ a little from what startPeriodicTimer was given if the counter clock doesn't divide evenly by it. */
+  Hertz ticksPerSecond();
+
+/** integer replacements for secondsForTicks(), truncating. Multiplies by reciprocals computed by startPeriodicTimer, no divides. */
+  u32 millisForTicks(SysTicks ticks);
+  u64 microsForTicks(SysTicks ticks);
+
 /** ticks necessary to get a periodic interrupt at the @param hz rate*/
   SysTicks ticksForHertz(float hz); //approximate since we know a divide is required.
 
   /** @returns the number of rollovers of the systick, typically units of millisecond or thereabouts */
   unsigned tocks();
+
+#if SYSTICK_HZ
+  inline TickPoint tickPoint() {
+    return TickPoint(TickSpan(SysTicks(snapLongTime())));
+  }
+#endif
+
+  /** @returns the most ticker routines that any one tick will call, as arranged by startPeriodicTimer. Compare to the count of all of them to see what spreading the DividedTickers gained. */
+  unsigned worstTickLoad();
+
+#if SYSTICK_PROFILE
+  /** execution time statistics of one SystemTicker, or of the whole tick isr */
+  struct TickerProfile {
+    /** which routine, look it up in the map file. nullptr for the whole tick */
+    SystemTicker ticker;
+    u32 calls;
+    u32 min;
+    u32 max;
+    u64 total;
+
+    void note(u32 took) {
+      if (calls == 0 || took < min) {
+        min = took;
+      }
+      if (took > max) {
+        max = took;
+      }
+      total += took;
+      ++calls;
+    }
+
+    u32 average() const {
+      return calls ? u32(total / calls) : 0;
+    }
+  };
+
+  /** copies the statistics of the @param index'th SystemTicker (table order) into @param copy, @returns false if there is no such ticker or it is past SYSTICK_PROFILE_SLOTS */
+  bool tickerProfile(unsigned index, TickerProfile &copy);
+
+  /** statistics of the whole tick isr, including DividedTickers and DeadlineTickers */
+  TickerProfile tickProfile();
+
+  /** @returns rate of the units the profile is in */
+  Hertz profileRate();
+
+  /** a tick that takes longer than @param units is counted as an overrun, 0 (the default) disables the check */
+  void setTickBudget(u32 units);
+
+  struct Overrun {
+    /** tick count when it last happened */
+    SysTicks when;
+    /** how long that tick took */
+    u32 took;
+    /** index of the SystemTicker that took the longest during that tick, ~0 if none did */
+    unsigned culprit;
+  };
+
+  /** @returns how many ticks have overrun the budget, and details of the latest in @param latest */
+  unsigned tickOverruns(Overrun &latest);
+
+  /** forget all statistics and overruns */
+  void resetProfile();
+
+  /** for dumping the profile, called once per line of text, without a line terminator */
+  using ProfileLine = void (*)(const char *line);
+
+  /** formats the profile as a table, one ticker per row, then the whole tick and the overrun summary */
+  void dumpProfile(ProfileLine out);
+#endif
+
+#if SYSTICK_TICKLESS
+  /** call after changing something a DeadlineTicker will report, to have the tick come no later than @param ticks from now.
+   * Does nothing if the tick is already due sooner. Restores the interrupt mask it found, so it can be called from anywhere including tickers and isrs more urgent than the tick. */
+  void wakeWithin(SysTicks ticks);
+#endif
 }
 
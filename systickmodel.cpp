@@ -0,0 +1,393 @@
+/*
+This commandline application checks that SystemTimer's time reads never go backwards.
+It runs the readers of systickread.h, the very code that systick.cpp uses, against a simulated SysTick counter and tick isr.
+The isr, and a reader more urgent than the tick, are let in before every access that a reader makes.
+
+Every access to the counter, the flags, or the isr's variables takes one counter clock. The model is swept over:
+  isr entry latency, in clocks from the reload;
+  how long the isr's tickers take every other tick, from nothing to over a tick so that it overruns, the others take none;
+  where in the isr a ticker reads the time;
+  the clock at which the more urgent reader runs.
+Thread mode readers run back to back throughout.
+A reading must be no less than any reading that finished before it began, and no more than the clock when it finished.
+In periodic mode it must also be no earlier than the clock when it began.
+
+Three isr designs are run in both periodic and tickless mode:
+  "M3" is what systick.cpp does on M3 and up, and must have no failures at all.
+  "M0" is what it does on M0's. The more urgent reader is expected to fail there (see systickread.h) but nothing else may.
+  "count first, pending only" is the original code, which must fail, as proof that the model sees the problem.
+
+To build:
+g++ -std=c++17 -O2 systickmodel.cpp
+mv a.out systickmodel
+
+systickmodel [verbose]
+*/
+
+#include <cstdio>
+#include "stdlib.h"
+#include "string.h"
+#include <vector>
+
+#include "systickread.h"
+
+using SysTickRead::Period;
+
+/** what differs between the isr designs */
+struct Design {
+  const char *name;
+  /** the periodic isr counts its tick after its tickers rather than before them */
+  bool countLast;
+  /** what active() tells a reader, per mode: 0 never, 1 only the isr itself (IPSR), 2 from entry to return (SHCSR) */
+  unsigned activePeriodic;
+  unsigned activeTickless;
+  /** the isr's final mask lasts until its exception return (FAULTMASK), else it is restored a clock before (PRIMASK) */
+  bool maskUntilReturn;
+  /** readers more urgent than the tick may fail */
+  bool urgentMayFail;
+  /** the model must find a failure */
+  bool mustFail;
+};
+
+static const Design designs[] = {
+  {"M3", true, 2, 2, true, false, false},
+  {"M0", false, 0, 1, false, true, false},
+  {"count first, pending only", false, 0, 0, false, true, true},
+};
+
+enum Level {
+  Thread, Tick, Urgent
+};
+
+struct Reading {
+  SysTime start;
+  SysTime end;
+  SysTime value;
+  Level level;
+  /** from SysTickRead::ticks or ticklessTicks, scaled to counts */
+  bool whole;
+};
+
+constexpr unsigned countsPerTick = 40;
+/** as in systick.cpp */
+constexpr unsigned Runway = 1u << 24;
+constexpr unsigned MinSegment = 32;
+/** tickless: what the tickers ask for, in turn */
+constexpr SysTicks wants[] = {1, 2, 3, 1, 1};
+constexpr unsigned horizon = 8 * countsPerTick;
+/** tickerAt for no ticker reading the time */
+constexpr unsigned NoTicker = ~0u;
+
+class Model {
+  const Design &design;
+  const bool tickless;
+  const unsigned latency;
+  const unsigned body;
+  const unsigned tickerAt;
+  const unsigned long long urgentAt;
+
+  //the SysTick
+  SysTime clock = 1;
+  unsigned down;
+  unsigned reload;
+  bool pend = false;
+  bool act = false;
+  SysTime pendingSince = 0;
+
+  //what is running
+  Level level = Thread;
+  bool masked = false;
+  bool urgentDone = false;
+
+  //the isr's variables
+  SysTicks milliTime = 0;
+  unsigned macroTime = 0;
+  Period periods[2];
+  unsigned current = 0;
+  unsigned wakeups = 0;
+  /** isr entries, every other one is a long one */
+  unsigned entries = 0;
+
+  /** one counter clock, at 0 it interrupts and on the clock after it reloads. A write of 0 reloads on the next clock without interrupting. */
+  void tick() {
+    if (++clock > 10 * horizon) {
+      printf("%s: livelock, latency %u body %u\n", design.name, latency, body);
+      exit(2);
+    }
+    if (down == 0) {
+      down = reload;
+    } else if (--down == 0) {
+      pend = true;
+      pendingSince = clock;
+    }
+  }
+
+  /** let in whatever is due and not masked */
+  void preempt() {
+    if (masked) {
+      return;
+    }
+    if (level < Urgent && !urgentDone && clock >= urgentAt) {
+      urgentDone = true;
+      read(Urgent, false);
+    }
+    while (level < Tick && pend && clock >= pendingSince + latency) {
+      isr();
+    }
+  }
+
+  /** every access costs a clock, and anything more urgent can come in before it */
+  void step() {
+    tick();
+    preempt();
+  }
+
+  void tock(SysTicks elapsed) {
+    SysTicks before = milliTime;
+    milliTime = before + elapsed;
+    if (milliTime < before) {
+      ++macroTime;
+    }
+  }
+
+  /** the tickers run every time, but they only take time every other time so that the thread readers get to finish */
+  void tickers() {
+    unsigned took = entries & 1 ? body : 0;
+    for (unsigned b = 0; b <= took; ++b) {
+      if (b == tickerAt) {
+        read(Tick, false);
+      }
+      if (b < took) {
+        step();
+      }
+    }
+  }
+
+  /** the code after the final mask is taken */
+  void finalStep() {
+    if (!design.maskUntilReturn) {
+      masked = false;
+    }
+    step();
+  }
+
+  void periodicIsr() {
+    if (!design.countLast) {
+      step();
+      tock(1);
+    }
+    tickers();
+    if (design.countLast) {
+      masked = true;
+      step();
+      tock(1);
+      finalStep();
+    } else {
+      step();
+    }
+  }
+
+  /** systick.cpp's restart(), access by access */
+  void restart(SysTime start, SysTicks ticks, unsigned countingFrom) {
+    Period &next = periods[(current + 1) & 1];
+    unsigned consumed = countingFrom - counter();
+    unsigned target = ticks * countsPerTick;
+    while (consumed + MinSegment > target) {
+      ++ticks;
+      target += countsPerTick;
+    }
+    unsigned remaining = target - consumed;
+    next.start = start;
+    next.ticks = ticks;
+    step();
+    reload = remaining - 1;
+    step();
+    down = 0;
+    while (counter() == 0) {}
+    step();
+    reload = Runway - 1;
+    next.loaded = Runway;
+    step();
+    current = current + 1;
+  }
+
+  void ticklessIsr() {
+    step();
+    const Period was = periods[current & 1];
+    tock(was.ticks);
+    tickers();
+    SysTicks soonest = wants[++wakeups % (sizeof(wants) / sizeof(wants[0]))];
+    masked = true;
+    restart(was.start + was.ticks, soonest, was.loaded);
+    finalStep();
+  }
+
+  void isr() {
+    Level was = level;
+    level = Tick;
+    ++entries;
+    pend = false;
+    act = true;
+    if (tickless) {
+      ticklessIsr();
+    } else {
+      periodicIsr();
+    }
+    //exception return
+    masked = false;
+    act = false;
+    level = was;
+  }
+
+  void read(Level at, bool whole) {
+    Level was = level;
+    level = at;
+    SysTime start = clock;
+    SysTime value;
+    if (whole) {
+      value = (tickless ? SysTickRead::ticklessTicks(*this, countsPerTick) : SysTickRead::ticks(*this)) * countsPerTick;
+    } else {
+      value = tickless ? SysTickRead::ticklessCounts(*this, countsPerTick) : SysTickRead::counts(*this, countsPerTick);
+    }
+    readings.push_back({start, clock, value, at, whole});
+    level = was;
+  }
+
+public:
+  std::vector<Reading> readings;
+
+  Model(const Design &design, bool tickless, unsigned latency, unsigned body, unsigned tickerAt, unsigned long long urgentAt) :
+    design(design), tickless(tickless), latency(latency), body(body), tickerAt(tickerAt), urgentAt(urgentAt) {
+    //as the clock ticks over to 1 the counter has just loaded its first segment
+    if (tickless) {
+      periods[0] = {0, wants[0], Runway};
+      down = wants[0] * countsPerTick - 1;
+      reload = Runway - 1;
+    } else {
+      down = countsPerTick - 1;
+      reload = countsPerTick - 1;
+    }
+  }
+
+  void run() {
+    for (bool whole = false; clock < horizon; whole = !whole) {
+      read(Thread, whole);
+    }
+  }
+
+  //the Hw interface of systickread.h
+  SysTicks millis() {
+    step();
+    return milliTime;
+  }
+
+  unsigned macros() {
+    step();
+    return macroTime;
+  }
+
+  unsigned counter() {
+    step();
+    return down;
+  }
+
+  bool pending() {
+    step();
+    return pend;
+  }
+
+  bool active() {
+    step();
+    switch (tickless ? design.activeTickless : design.activePeriodic) {
+    case 0:
+      return false;
+    case 1:
+      return level == Tick;
+    default:
+      return act;
+    }
+  }
+
+  unsigned generation() {
+    step();
+    return current;
+  }
+
+  const Period &period(unsigned generation) {
+    step();
+    return periods[generation & 1];
+  }
+};
+
+struct Tally {
+  unsigned runs = 0;
+  unsigned long long readings = 0;
+  /** failures in which a reader more urgent than the tick took part */
+  unsigned urgent = 0;
+  unsigned others = 0;
+};
+
+static bool verbose = false;
+
+static void complain(const char *what, const Reading &later, const Reading *earlier) {
+  static const char *const levels[] = {"thread", "tick isr", "urgent"};
+  printf("  %s: %s reading %llu over [%llu,%llu]", what, levels[later.level], (unsigned long long) later.value, (unsigned long long) later.start, (unsigned long long) later.end);
+  if (earlier) {
+    printf(" after %s reading %llu over [%llu,%llu]", levels[earlier->level], (unsigned long long) earlier->value, (unsigned long long) earlier->start, (unsigned long long) earlier->end);
+  }
+  printf("\n");
+}
+
+/** checks every reading of @param model against the clock and against every reading that finished before it began */
+static void check(const Model &model, bool tickless, Tally &tally) {
+  ++tally.runs;
+  tally.readings += model.readings.size();
+  for (const Reading &b: model.readings) {
+    bool bad = b.value > b.end || (!tickless && b.value + (b.whole ? countsPerTick : 0) < b.start);
+    if (bad) {
+      if (verbose) {
+        complain("off the clock", b, nullptr);
+      }
+      ++(b.level == Urgent ? tally.urgent : tally.others);
+      continue;
+    }
+    for (const Reading &a: model.readings) {
+      if (a.end <= b.start && a.whole == b.whole && a.value > b.value) {
+        if (verbose) {
+          complain("went back", b, &a);
+        }
+        ++(a.level == Urgent || b.level == Urgent ? tally.urgent : tally.others);
+        break;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  verbose = argc > 1 && strcmp(argv[1], "verbose") == 0;
+  const unsigned latencies[] = {0, 1, 3};
+  const unsigned bodies[] = {0, 1, 3, countsPerTick - 1, countsPerTick + 2};
+
+  bool wrong = false;
+  for (const Design &design: designs) {
+    for (bool tickless: {false, true}) {
+      Tally tally;
+      for (unsigned latency: latencies) {
+        for (unsigned body: bodies) {
+          for (unsigned tickerAt: {NoTicker, 0u, body / 2, body}) {
+            for (unsigned long long urgentAt = 1; urgentAt <= horizon; ++urgentAt) {
+              Model model(design, tickless, latency, body, tickerAt, urgentAt);
+              model.run();
+              check(model, tickless, tally);
+            }
+          }
+        }
+      }
+      bool ok = design.mustFail ? tally.urgent + tally.others > 0 : tally.others == 0 && (design.urgentMayFail || tally.urgent == 0);
+      printf("%-26s %-8s %6u runs %9llu readings, failures: %6u with an urgent reader, %6u without  %s\n",
+        design.name, tickless ? "tickless" : "periodic", tally.runs, tally.readings, tally.urgent, tally.others, ok ? "as expected" : "WRONG");
+      wrong |= !ok;
+    }
+  }
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "systick.h" //SysTicks, SysTime
+
+/**
+How SystemTimer reads the time without stopping the SysTick counter, apart from the registers so that systickmodel.cpp can run this same code against a simulated counter and tick isr.
+
+The counter reloading and the tick isr counting that reload can't be one step, a reader that lands between the two has to count the reload itself:
+  ICSR.PENDSTSET is set from the reload until the isr is entered,
+  SHCSR.SYSTICKACT is set from the isr's entry until its exception return, both for a reader that has preempted the isr and for one that is the isr (a ticker).
+Entry clears the pending flag before any of the isr's code runs, so watching pending alone leaves a window in which the time goes back a whole period.
+
+So the isr does its accounting as its very last act, with every exception masked (FAULTMASK) from there to its exception return, which is what unmasks.
+A reader never sees the accounting done while the isr is still active, and the reloads it has to count itself are simply pending + active.
+A reader less urgent than the tick never sees either set for long, the isr preempts it and the tick count changes under it, so it reads again.
+
+M0's have neither FAULTMASK nor a SHCSR that software can read. The periodic isr there counts its tick as its first act and 'active' is always false,
+tickless uses 'active' only for the isr itself (IPSR) as it can't restart the counter until its tickers have said what they want.
+A reader more urgent than the tick can then see the time go back a period, from entry to the isr to its accounting, which is the isr's first few instructions in periodic mode and all of it in tickless.
+
+Hw supplies:
+  SysTicks millis(); unsigned macros();  the tick count the isr maintains, low and high words
+  unsigned counter();  the down counter
+  bool pending(); bool active();  as above
+  unsigned generation();  tickless: count of period changes, which also picks the slot
+  const Period &period(unsigned generation);
+*/
+namespace SysTickRead {
+  /** tickless mode: the counter no longer runs one tick per reload, each 'period' is a whole number of ticks starting at a known count.
+   * The counter itself is restarted via a write to its value, which makes it reload on its next clock, so a period is usually made of
+   * a first segment (what is left of the period after isr latency or after shortening) that ends the period,
+   * followed by systick.cpp's Runway reload of 2^24 counts, long enough that the isr always restarts the counter before it comes round again.
+   * The next period is built in the slot not in use and then the generation is incremented, so a reader at any priority gets a consistent set. */
+  struct Period {
+    /** tick count at which this period began, periods begin and end on whole ticks */
+    SysTime start;
+    /** length of this period, the counter will interrupt at start + ticks*countsPerTick */
+    SysTicks ticks;
+    /** what the counter reloads with at the end of a segment, reload+1 */
+    unsigned loaded;
+  };
+
+  /** @returns reloads the isr hasn't counted yet.
+   * Entry clears pending and sets active at once, reading active first means a reader that straddles that undercounts rather than counting one reload twice,
+   * and an undercount is caught by the callers' recheck. */
+  template<typename Hw> unsigned uncounted(Hw &hw) {
+    unsigned active = hw.active();
+    return active + hw.pending();
+  }
+
+  /** periodic mode, the tick count with the reloads the isr hasn't counted yet */
+  template<typename Hw> SysTime ticks(Hw &hw) {
+    SysTicks snapms;
+    SysTime whole;
+    do {
+      snapms = hw.millis();
+      whole = snapms | (SysTime(hw.macros()) << 32);
+      whole += uncounted(hw);
+    } while (snapms != hw.millis());
+    return whole;
+  }
+
+  /** periodic mode, counter clocks since start.
+   * The flags are read before and after the counter, a reload between them changes the flags so we read again, as we do if a less urgent isr changes the tick count. */
+  template<typename Hw> SysTime counts(Hw &hw, unsigned countsPerTick) {
+    SysTicks snapms;
+    SysTime whole;
+    unsigned reloads;
+    unsigned snaptick;
+    do {
+      snapms = hw.millis();
+      whole = snapms | (SysTime(hw.macros()) << 32);
+      reloads = uncounted(hw);
+      snaptick = hw.counter();
+    } while (reloads != uncounted(hw) || snapms != hw.millis());
+    whole += reloads;
+    //a down counter, the tick happens on the transition to 0 so 0 is the start of a period, reload is one count into it.
+    return whole * countsPerTick + (snaptick ? countsPerTick - snaptick : 0);
+  }
+
+  /** tickless mode, where we are in the present period. The counter has the end of it coming at start + ticks, and it interrupts at zero.
+   * If it has interrupted but the isr hasn't yet started the next period it has reloaded with 'loaded' and we add that on.
+   * @returns the tick count at which the period began, @param into is set to the counter clocks since then, which can't exceed 2^25 */
+  template<typename Hw> SysTime ticklessPosition(Hw &hw, unsigned countsPerTick, unsigned &into) {
+    unsigned generation;
+    Period p;
+    unsigned reloads;
+    unsigned snaptick;
+    do {
+      generation = hw.generation();
+      p = hw.period(generation); //a copy, two restarts could reuse the slot once we are done looking
+      reloads = uncounted(hw);
+      snaptick = hw.counter();
+    } while (reloads != uncounted(hw) || generation != hw.generation());
+    unsigned length = p.ticks * countsPerTick;
+    into = reloads ? length + (p.loaded - snaptick) : length - snaptick;
+    return p.start;
+  }
+
+  /** tickless mode, counter clocks since start */
+  template<typename Hw> SysTime ticklessCounts(Hw &hw, unsigned countsPerTick) {
+    unsigned into;
+    SysTime start = ticklessPosition(hw, countsPerTick, into);
+    return start * countsPerTick + into;
+  }
+
+  /** tickless mode, ticks since start, with a 32 bit divide rather than dividing the 64 bit count */
+  template<typename Hw> SysTime ticklessTicks(Hw &hw, unsigned countsPerTick) {
+    unsigned into;
+    SysTime start = ticklessPosition(hw, countsPerTick, into);
+    return start + into / countsPerTick;
+  }
+
+}
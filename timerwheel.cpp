@@ -0,0 +1,175 @@
+#include "timerwheel.h"
+
+#include "nvic.h"  //InterruptMask
+
+/** arming is a handful of pointer moves, we just keep the tick out for that long. Restores rather than enables so that it can be used in an isr or critical section. */
+using WheelLock = InterruptMask;
+
+struct TimerWheel {
+  enum : unsigned {
+    RootBits = 8,
+    LevelBits = 6,
+    Levels = 3, //above the root
+    RootSize = 1 << RootBits,
+    LevelSize = 1 << LevelBits,
+    /** beyond this timers get parked in the top level */
+    Span = 1 << (RootBits + Levels * LevelBits),
+  };
+
+  /** the wheel's notion of the tick count, only the tick isr alters it */
+  SysTicks now = 0;
+
+  WheelTimer *root[RootSize] = {};
+  WheelTimer *level[Levels][LevelSize] = {};
+
+  static constexpr unsigned shiftFor(unsigned lvl) {
+    return RootBits + lvl * LevelBits;
+  }
+
+  static void link(WheelTimer *&head, WheelTimer &t) {
+    t.next = head;
+    if (head) {
+      head->pprev = &t.next;
+    }
+    head = &t;
+    t.pprev = &head;
+  }
+
+  static void unlink(WheelTimer &t) {
+    if (t.pprev) {
+      *t.pprev = t.next;
+      if (t.next) {
+        t.next->pprev = t.pprev;
+      }
+      t.next = nullptr;
+      t.pprev = nullptr;
+    }
+  }
+
+  /** pick the bucket by how far off the expiry is */
+  void insert(WheelTimer &t) {
+    SysTicks delta = t.expires - now;
+    if (delta < RootSize) {
+      link(root[t.expires & (RootSize - 1)], t);
+      return;
+    }
+    for (unsigned lvl = 0; lvl < Levels; ++lvl) {
+      if (delta < (1u << shiftFor(lvl + 1))) {
+        link(level[lvl][(t.expires >> shiftFor(lvl)) & (LevelSize - 1)], t);
+        return;
+      }
+    }
+    //too far off: park it in the top bucket that is visited last, it will be reinserted from there.
+    link(level[Levels - 1][((now >> shiftFor(Levels - 1)) + LevelSize - 1) & (LevelSize - 1)], t);
+  }
+
+  /** move a bucket's worth of timers to finer buckets */
+  void cascade(unsigned lvl) {
+    WheelTimer *&bucket = level[lvl][(now >> shiftFor(lvl)) & (LevelSize - 1)];
+    WheelTimer *list = bucket;
+    bucket = nullptr;
+    while (list) {
+      WheelTimer &t = *list;
+      list = t.next;
+      t.pprev = nullptr;
+      t.next = nullptr;
+      insert(t);
+    }
+  }
+
+  void tick() {
+    ++now;
+    //going from coarse to fine so that things fall all the way down in one tick.
+    if ((now & (RootSize - 1)) == 0) {
+      unsigned lvl = 0;
+      while (lvl + 1 < Levels && ((now >> shiftFor(lvl)) & (LevelSize - 1)) == 0) {
+        ++lvl;
+      }
+      do {
+        cascade(lvl);
+      } while (lvl-- > 0);
+    }
+    WheelTimer *&bucket = root[now & (RootSize - 1)];
+    WheelTimer *list = bucket;
+    bucket = nullptr;
+    while (list) {
+      WheelTimer &t = *list;
+      list = t.next;
+      t.pprev = nullptr;
+      t.next = nullptr;
+      if (t.expires == now) {
+        t.done = true;
+        t.onDone();//might rearm
+      } else {
+        insert(t);//only a parked timer should get here.
+      }
+    }
+  }
+
+  /** @returns ticks until the next root bucket with something in it, or till the root wraps and a cascade is due */
+  SysTicks nextDue() const {
+    SysTicks ahead = 1;
+    for (SysTicks upto = RootSize - (now & (RootSize - 1)); ahead < upto; ++ahead) {
+      if (root[(now + ahead) & (RootSize - 1)]) {
+        return ahead;
+      }
+    }
+    return ahead;
+  }
+};
+
+static TimerWheel theWheel;
+
+void WheelTimer::armIn(SysTicks ticks) {
+  SysTicks due;
+  {
+    WheelLock lock;
+    TimerWheel::unlink(*this);
+    done = false;
+    due = theWheel.now + ticks;
+    expires = due;
+    theWheel.insert(*this);
+  }
+#if SYSTICK_TICKLESS
+  SystemTimer::wakeWithin(due - theWheel.now);
+#endif
+}
+
+WheelTimer::~WheelTimer() {
+  freeze();
+}
+
+void WheelTimer::restart(SysTicks ticks) {
+  period = ticks;
+  retrigger();
+}
+
+void WheelTimer::retrigger() {
+  armIn(period ? period : 1);
+}
+
+void WheelTimer::freeze() {
+  WheelLock lock;
+  TimerWheel::unlink(*this);
+}
+
+void CyclicWheelTimer::onDone() {
+  fired = true;
+  if (period) {
+    //from when it was due, not from now, so there is no cumulative drift. We are in the tick isr so no lock needed.
+    expires += period;
+    done = false;
+    theWheel.insert(*this);
+  }
+}
+
+void TimerWheelService() {
+  theWheel.tick();
+}
+
+SysTicks TimerWheelDeadline(SysTicks elapsed) {
+  while (elapsed-- > 0) {
+    theWheel.tick();
+  }
+  return theWheel.nextDue();
+}
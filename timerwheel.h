@@ -0,0 +1,105 @@
+#pragma once
+
+#include "systick.h"
+
+/**
+software timers on a hierarchical timing wheel, driven by the system tick.
+
+Each PolledTimer style timer decrements its own counter every tick, so the tick isr costs O(number of timers).
+Here a timer sits in a bucket for its expiry time, arming and cancelling are O(1) list operations,
+and a tick only looks at the one bucket that is expiring, plus now and then moving a bucket of far off timers down a level.
+
+Levels: 256 one-tick buckets, then 3 levels of 64 buckets each 64 times coarser, covering 2^26 ticks (18 hours at 1kHz).
+Longer delays work, they just get looked at once per 2^20 ticks until they are close enough.
+
+Usage, in one module:
+  #include "timerwheel.h"
+  RegisterTimerWheelWithSysTick  //or RegisterTimerWheelAsDeadlineTicker for tickless builds
+then
+  CyclicWheelTimer ledToggle;
+  ledToggle.restart(Time::Millis(750)); //or restartSeconds(0.75)
+  ... if(ledToggle){ toggle(); }
+*/
+
+class WheelTimer {
+  friend struct TimerWheel;
+  /** intrusive list, pprev points to whatever points to us, nullptr when not armed */
+  WheelTimer *next = nullptr;
+  WheelTimer **pprev = nullptr;
+
+protected:
+  /** tick count at which we are due */
+  SysTicks expires = 0;
+
+  /** called from the tick isr when the time is up, after 'done' is set. Keep it short. */
+  virtual void onDone() {}
+
+  /** arm for @param ticks past the wheel's own tick count, read under the same lock as the insert so that a tick can't slip in between */
+  void armIn(SysTicks ticks);
+
+public:
+  /** ticks used by retrigger() */
+  SysTicks period;
+  /** set when the time is up, cleared when armed */
+  volatile bool done = false;
+
+  explicit WheelTimer(SysTicks period = 0) : period(period) {}
+
+  virtual ~WheelTimer();
+
+  /** set the period and start timing */
+  void restart(SysTicks ticks);
+
+  /** a template so that restart(100) still means ticks */
+  template<typename R, u64 N, u64 D> void restart(Time::Duration<R, N, D> span) {
+    restart(SystemTimer::ticksFor(span));
+  }
+
+  void restartSeconds(double seconds) {
+    restart(SystemTimer::ticksForSeconds(float(seconds)));
+  }
+
+  /** start timing again with the existing period, such as for a retriggerable monostable */
+  void retrigger();
+
+  /** cancel, without setting done */
+  void freeze();
+
+  bool isRunning() const {
+    return pprev != nullptr;
+  }
+
+  /** @returns whether the time is up */
+  operator bool() const {
+    return done;
+  }
+};
+
+/** restarts itself each time it expires, without accumulating the latency of whoever polls it. */
+class CyclicWheelTimer : public WheelTimer {
+  /** set with each expiration, cleared by the operator bool */
+  volatile bool fired = false;
+protected:
+  void onDone() override;
+public:
+  using WheelTimer::WheelTimer;
+
+  /** @returns whether it has expired since the last time you asked. */
+  operator bool() {
+    if (fired) {
+      fired = false;
+      return true;
+    }
+    return false;
+  }
+};
+
+/** system tick service, one tick per call */
+void TimerWheelService();
+
+/** tickless system tick service, @returns ticks until the next bucket that has something in it */
+SysTicks TimerWheelDeadline(SysTicks elapsed);
+
+#include "tableofpointers.h"
+#define RegisterTimerWheelWithSysTick MakeRef(SystemTicker,TimerWheelService);
+#define RegisterTimerWheelAsDeadlineTicker MakeRef(DeadlineTicker,TimerWheelDeadline);